@@ -2,11 +2,27 @@
 
 #include <cstdint>
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <span>
 #include <climits>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <bit>
+
+#if defined(FREN_STAGE_TIMING)
+#include <chrono>
+#endif
 
 #include "frenmath.hpp"
+#include "frenring.hpp"
 
 namespace fren
 {
@@ -28,12 +44,217 @@ constexpr auto Convert555to888(uint16_t color) -> std::array<uint8_t, 4>
     return {red,green,blue,alpha};
 }
 
+//scalar type of the clip space pipeline, see Context::setPrecision
+enum class Precision : uint8_t
+{
+    Fixed,
+    Float,
+    Double
+};
+
+enum class IndexType
+{
+    UInt8,
+    UInt16,
+    UInt32
+};
+
 enum class DrawType
 {
     Points,
     Lines,
     Line_Strip,
-    Line_Loop
+    Line_Loop,
+    Triangles,
+    Triangle_Strip,
+    Triangle_Fan
+};
+
+//which filled triangles Context::setCullFace drops, front faces wind counter clockwise in normalized device coordinates
+enum class CullFace : uint8_t
+{
+    None,
+    Back,
+    Front
+};
+
+//what Context::setSegmentOptimization does to the segments and points of line draws after primitive assembly
+struct SegmentOptimization
+{
+    bool dedup = false;     //drops segments repeating an earlier one of the draw, in either direction and with the same color
+    bool merge = false;     //joins consecutive segments of one color that carry on in exactly the same direction
+};
+
+//component types for VertexPointer, integers are whole units, float is converted to 16.16
+enum class ComponentType : uint8_t
+{
+    Int8,
+    Int16,
+    Fixed32,
+    Float
+};
+
+//N components of T every stride bytes, widened to a homogeneous vec4 of the pipeline scalar inside the gather loop
+//reads go through memcpy so interleaved structs need no particular alignment
+template<class T, uint8_t N>
+struct StridedVertices
+{
+    uint8_t const* base;
+    uint32_t stride;
+
+    template<math::Scalar S>
+    auto get(uint32_t const i) const -> math::basic_vec4<S>
+    {
+        math::basic_vec4<S> v{S(0.0f), S(0.0f), S(0.0f), S(1.0f)};
+        uint8_t const* const p = base + std::size_t(i) * stride;
+        for(uint8_t c = 0; c < N; ++c)
+        {
+            T t;
+            std::memcpy(&t, p + c * sizeof(T), sizeof(T));
+            v[c] = widen<S>(t);
+        }
+        return v;
+    }
+
+    auto operator+(uint32_t const first) const -> StridedVertices
+    {
+        return {base + std::size_t(first) * stride, stride};
+    }
+
+    //Fixed32 components are read as their raw int32_t
+    template<math::Scalar S>
+    static auto widen(T const t) -> S
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return math::scalar_cast<S>(t);
+        }
+        else if constexpr (std::is_same_v<T, int32_t>)
+        {
+            return math::scalar_cast<S>(math::fromRaw(t));
+        }
+        else
+        {
+            return math::scalar_cast<S>(math::fromRaw(int32_t(t) * 65536));
+        }
+    }
+};
+
+//555 colors every stride bytes, a null base means no colors
+struct StridedColors
+{
+    uint8_t const* base;
+    uint32_t stride;
+
+    auto operator[](uint32_t const i) const -> uint16_t
+    {
+        uint16_t c;
+        std::memcpy(&c, base + std::size_t(i) * stride, sizeof(c));
+        return c;
+    }
+
+    auto operator+(uint32_t const first) const -> StridedColors
+    {
+        return {base ? base + std::size_t(first) * stride : nullptr, stride};
+    }
+
+    explicit operator bool() const
+    {
+        return base != nullptr;
+    }
+};
+
+template<math::Scalar T>
+struct BasicVertex
+{
+    fren::math::basic_vec4<T> pos;
+    uint16_t col;
+    uint8_t clip = 0;   //outcode, one bit per clip plane the vertex is outside of
+};
+
+using Vertex = BasicVertex<math::fixed32>;
+
+//outcode bits, ordered like the planes in plane_distance
+enum ClipPlane : uint8_t
+{
+    ClipRight  = 1 << 0,    // x > w
+    ClipLeft   = 1 << 1,    // x < -w
+    ClipTop    = 1 << 2,    // y > w
+    ClipBottom = 1 << 3,    // y < -w
+    ClipFar    = 1 << 4,    // z > w
+    ClipNear   = 1 << 5     // z < -w
+};
+
+//pipeline stages as seen by the optional FREN_STAGE_TIMING timers
+enum class PipelineStage
+{
+    Gather,
+    Vertex,
+    Lines,
+    Clip,       //outcodes, clipping and face culling
+    Ndc,        //perspective divide and window transform, one fused pass
+    Viewport,   //float and double pipelines only, quantizing window space to 16.16
+    Draw,
+    Count
+};
+
+//what the pipeline did with the draws since the last reset, like gl pipeline statistics queries
+//only counted when built with FREN_PIPELINE_STATS, otherwise the counting compiles away
+struct PipelineStats
+{
+    uint64_t draws = 0;
+    uint64_t culled = 0;            //draws skipped whole because their bounds were outside the view volume
+    uint64_t vertices = 0;          //submitted, the index count for indexed draws
+    uint64_t shaded = 0;            //run through the vertex stage, unique vertices for indexed draws
+    uint64_t primitives = 0;        //points, segments or triangles after primitive assembly
+    uint64_t deduplicated = 0;      //segments and points dropped as repeats, see Context::setSegmentOptimization
+    uint64_t merged = 0;            //segments joined into the one before them, likewise
+    uint64_t accepted = 0;          //trivially inside the view volume
+    uint64_t clipped = 0;           //crossing the view volume and clipped to it
+    uint64_t rejected = 0;          //outside, trivially or after clipping
+    uint64_t discarded = 0;         //triangles dropped after clipping, by face culling or for covering no area
+    uint64_t points = 0;            //handed to the backend through points()
+    uint64_t segments = 0;          //handed to the backend through lines()
+    uint64_t triangles = 0;         //handed to the backend through triangles()
+    uint64_t pixels = 0;            //written, only counted by backends that rasterize themselves
+    uint64_t occluded = 0;          //failed the depth test, likewise
+};
+
+//object space box around the vertices of the following draws, see Context::setBounds
+struct Bounds
+{
+    math::vec3 min, max;
+
+    //the box around a sphere, tested like any other box so the test stays conservative
+    static constexpr auto sphere(math::vec3 const& center, math::fixed32 const radius) -> Bounds
+    {
+        return {{{center.x - radius, center.y - radius}, center.z - radius},
+                {{center.x + radius, center.y + radius}, center.z + radius}};
+    }
+
+    //box around a vertex buffer, meant to be computed once and kept next to it
+    //vec2 positions sit at z = 0, the w of vec4 positions is ignored
+    template<class Vec>
+    static constexpr auto of(std::span<const Vec> const verts) -> Bounds
+    {
+        Bounds b{};
+        for(std::size_t i = 0; i < verts.size(); ++i)
+        {
+            math::fixed32 z{};
+            if constexpr (!std::is_same_v<Vec, math::vec2>)
+            {
+                z = verts[i].z;
+            }
+            if(i == 0)
+            {
+                b.min = b.max = {{verts[i].x, verts[i].y}, z};
+                continue;
+            }
+            b.min = {{std::min(b.min.x, verts[i].x), std::min(b.min.y, verts[i].y)}, std::min(b.min.z, z)};
+            b.max = {{std::max(b.max.x, verts[i].x), std::max(b.max.y, verts[i].y)}, std::max(b.max.z, z)};
+        }
+        return b;
+    }
 };
 
 class VertexFunction
@@ -42,6 +263,395 @@ public:
     VertexFunction() {}
     virtual ~VertexFunction() {}
     virtual fren::math::vec4 operator()(const fren::math::vec4& in) = 0;
+
+    //a shader that is nothing but a matrix returns it here,
+    //the context then runs the simd kernels over the whole stream instead of calling the shader
+    virtual auto matrix() const -> const fren::math::mat4*
+    {
+        return nullptr;
+    }
+
+    //batch entry point, transforms verts in place
+    //default falls back to one virtual call per vertex, override to keep the loop inside the shader
+    virtual void transform(std::span<Vertex> verts)
+    {
+        for (auto& v : verts)
+        {
+            v.pos = (*this)(v.pos);
+        }
+    }
+};
+
+//static dispatch base, Shader provides a non virtual shade(const vec4&)
+//which both the batch loop and the templated DrawArray/DrawElements inline
+template<class Shader>
+class StaticVertexFunction : public VertexFunction
+{
+public:
+    fren::math::vec4 operator()(const fren::math::vec4& in) final
+    {
+        return static_cast<Shader&>(*this).shade(in);
+    }
+
+    void transform(std::span<Vertex> verts) final
+    {
+        Shader& s = static_cast<Shader&>(*this);
+        for (auto& v : verts)
+        {
+            v.pos = s.shade(v.pos);
+        }
+    }
+};
+
+//the stock matrix shader, picked up by the simd path through matrix()
+class MatrixVertexFunction : public VertexFunction
+{
+public:
+    fren::math::mat4 mvp = fren::math::identity();
+
+    fren::math::vec4 operator()(const fren::math::vec4& in) override
+    {
+        return mvp * in;
+    }
+
+    void transform(std::span<Vertex> verts) override
+    {
+        for (auto& v : verts)
+        {
+            v.pos = mvp * v.pos;
+        }
+    }
+
+    auto matrix() const -> const fren::math::mat4* override
+    {
+        return &mvp;
+    }
+};
+
+template<class T, std::size_t ALIGN>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, ALIGN>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<class U>
+    AlignedAllocator(AlignedAllocator<U, ALIGN> const &) {}
+
+    auto allocate(std::size_t const n) -> T*
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGN)));
+    }
+
+    void deallocate(T* const p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(ALIGN));
+    }
+
+    template<class U>
+    auto operator==(AlignedAllocator<U, ALIGN> const &) const -> bool
+    {
+        return true;
+    }
+};
+
+//structure of arrays vertex storage, one 32 byte aligned array per component
+//arrays are padded to math::SOA_LANES so the kernels never need a scalar tail
+//fixed32 lanes hold the raw 16.16 value, float and double lanes the value itself
+template<math::Scalar S>
+class BasicVertexStream
+{
+public:
+    template<class T>
+    using Array = std::vector<T, AlignedAllocator<T, 32>>;
+    using Lane = std::conditional_t<std::is_same_v<S, math::fixed32>, int32_t, S>;
+
+    Array<Lane> x, y, z, w;
+    Array<uint16_t> col;
+    Array<uint8_t> clip;
+
+    auto size() const -> uint32_t
+    {
+        return count;
+    }
+
+    auto padded() const -> uint32_t
+    {
+        return (count + math::SOA_LANES - 1) & ~uint32_t(math::SOA_LANES - 1);
+    }
+
+    void resize(uint32_t const n)
+    {
+        count = n;
+        uint32_t const p = padded();
+        x.resize(p);
+        y.resize(p);
+        z.resize(p);
+        w.resize(p);
+        col.resize(p);
+        clip.resize(p);
+    }
+
+    void reserve(uint32_t const n)
+    {
+        uint32_t const p = (n + math::SOA_LANES - 1) & ~uint32_t(math::SOA_LANES - 1);
+        x.reserve(p);
+        y.reserve(p);
+        z.reserve(p);
+        w.reserve(p);
+        col.reserve(p);
+        clip.reserve(p);
+    }
+
+    static auto scalar(Lane const l) -> S
+    {
+        if constexpr (std::is_same_v<S, math::fixed32>)
+        {
+            return math::fromRaw(l);
+        }
+        else
+        {
+            return l;
+        }
+    }
+
+    static auto lane(S const v) -> Lane
+    {
+        if constexpr (std::is_same_v<S, math::fixed32>)
+        {
+            return v.data;
+        }
+        else
+        {
+            return v;
+        }
+    }
+
+    auto get(uint32_t const i) const -> math::basic_vec4<S>
+    {
+        return {scalar(x[i]), scalar(y[i]), scalar(z[i]), scalar(w[i])};
+    }
+
+    void set(uint32_t const i, math::basic_vec4<S> const & v)
+    {
+        x[i] = lane(v.x);
+        y[i] = lane(v.y);
+        z[i] = lane(v.z);
+        w[i] = lane(v.w);
+    }
+
+    auto vertex(uint32_t const i) const -> BasicVertex<S>
+    {
+        return BasicVertex<S>{get(i), col[i], clip[i]};
+    }
+
+    void setVertex(uint32_t const i, BasicVertex<S> const & v)
+    {
+        set(i, v.pos);
+        col[i] = v.col;
+        clip[i] = v.clip;
+    }
+
+    void copy(uint32_t const dst, BasicVertexStream const & src, uint32_t const i)
+    {
+        x[dst] = src.x[i];
+        y[dst] = src.y[i];
+        z[dst] = src.z[i];
+        w[dst] = src.w[i];
+        col[dst] = src.col[i];
+        clip[dst] = src.clip[i];
+    }
+
+    //n vertices of src starting at first into dst onwards, both ranges must already be sized
+    void copy(uint32_t const dst, BasicVertexStream const & src, uint32_t const first, uint32_t const n)
+    {
+        std::copy_n(src.x.begin() + first, n, x.begin() + dst);
+        std::copy_n(src.y.begin() + first, n, y.begin() + dst);
+        std::copy_n(src.z.begin() + first, n, z.begin() + dst);
+        std::copy_n(src.w.begin() + first, n, w.begin() + dst);
+        std::copy_n(src.col.begin() + first, n, col.begin() + dst);
+        std::copy_n(src.clip.begin() + first, n, clip.begin() + dst);
+    }
+
+private:
+    uint32_t count = 0;
+};
+
+//the stream type of the fixed32 pipeline and of every window space stream handed to backends
+using VertexStream = BasicVertexStream<math::fixed32>;
+
+//half-space setup of one window space triangle, shared by the default Context::triangles and rasterizing backends
+//vertices snap to 28.4 subpixels, e(k) = a[k] * x + b[k] * y + c[k] is evaluated at the center of pixel x, y
+//a pixel is covered when all three are >= 0, edges other than top and left edges are biased by one
+//so pixels on an edge shared by two triangles are filled exactly once
+struct TriangleSetup
+{
+    int64_t a[3], b[3], c[3];
+    int32_t xmin, ymin, xmax, ymax;     //pixels that can be covered, clamped to the viewport
+    uint16_t color;                     //of the first vertex
+
+    //triangle in[i, i + 3), false when it has no area or covers no pixel center
+    auto setup(VertexStream const & in, uint32_t const i, uint16_t const xres, uint16_t const yres) -> bool
+    {
+        int64_t x[3], y[3];
+        for(uint8_t k = 0; k < 3; ++k)
+        {
+            x[k] = in.x[i + k] >> 12;
+            y[k] = in.y[i + k] >> 12;
+        }
+
+        //either winding, the inside is where all edge functions are positive
+        int64_t const area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if(area == 0)
+        {
+            return false;
+        }
+        if(area < 0)
+        {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+        }
+
+        for(uint8_t k = 0; k < 3; ++k)
+        {
+            uint8_t const n = k == 2 ? 0 : k + 1;
+            int64_t const ea = y[k] - y[n];
+            int64_t const eb = x[n] - x[k];
+            bool const top_left = ea > 0 || (ea == 0 && eb > 0);
+            //pixel centers sit at 16 * p + 8 in subpixels
+            a[k] = ea * 16;
+            b[k] = eb * 16;
+            c[k] = ea * (8 - x[k]) + eb * (8 - y[k]) - (top_left ? 0 : 1);
+        }
+
+        xmin = static_cast<int32_t>(std::max<int64_t>(0, -((8 - std::min({x[0], x[1], x[2]})) >> 4)));
+        ymin = static_cast<int32_t>(std::max<int64_t>(0, -((8 - std::min({y[0], y[1], y[2]})) >> 4)));
+        xmax = static_cast<int32_t>(std::min<int64_t>(int64_t(xres) - 1, (std::max({x[0], x[1], x[2]}) - 8) >> 4));
+        ymax = static_cast<int32_t>(std::min<int64_t>(int64_t(yres) - 1, (std::max({y[0], y[1], y[2]}) - 8) >> 4));
+        color = in.col[i];
+        return xmin <= xmax && ymin <= ymax;
+    }
+
+    auto edge(uint8_t const k, int32_t const x, int32_t const y) const -> int64_t
+    {
+        return a[k] * x + b[k] * y + c[k];
+    }
+
+    //covered pixels of row y as x0..x1, empty when x0 > x1
+    void span(int32_t const y, int32_t& x0, int32_t& x1) const
+    {
+        int64_t lo = xmin;
+        int64_t hi = xmax;
+        for(uint8_t k = 0; k < 3; ++k)
+        {
+            int64_t const e = b[k] * y + c[k];
+            if(a[k] > 0)
+            {
+                lo = std::max(lo, -floor_div(e, a[k]));
+            }
+            else if(a[k] < 0)
+            {
+                hi = std::min(hi, floor_div(e, -a[k]));
+            }
+            else if(e < 0)
+            {
+                hi = lo - 1;
+            }
+        }
+        x0 = static_cast<int32_t>(lo);
+        x1 = static_cast<int32_t>(std::max(hi, lo - 1));
+    }
+
+    static auto floor_div(int64_t const n, int64_t const d) -> int64_t
+    {
+        int64_t const q = n / d;
+        return (n % d != 0 && n < 0) ? q - 1 : q;
+    }
+};
+
+//recorded draws between Context::NewList and EndList
+//owns the gathered vertices and the assembled primitives, so replay skips gather and primitive assembly
+//consecutive draws with the same vertex function state are merged into one batch
+//batches with a snapshotted matrix also keep their window space result, replay then only draws it
+class DisplayList
+{
+public:
+    void clear()
+    {
+        verts.resize(0);
+        prims.clear();
+        screen.resize(0);
+        batches.clear();
+        screen_xres = 0;
+        screen_yres = 0;
+    }
+
+    auto empty() const -> bool
+    {
+        return batches.empty();
+    }
+
+    //number of batches replay runs through the pipeline
+    auto size() const -> uint32_t
+    {
+        return batches.size();
+    }
+
+private:
+    friend class Context;
+
+    struct Batch
+    {
+        uint32_t first, count;              //vertex range in verts
+        uint32_t prim_first, prim_count;    //point, segment or triangle indices in prims, relative to first
+        VertexFunction* shader;             //live shader called on replay, nullptr when matrix holds the state
+        math::mat4 matrix;
+        uint8_t vertices;                   //per primitive, 1 for points, 2 for segments and 3 for triangles
+        CullFace cull;                      //snapshotted at the draw like the matrix
+        uint32_t screen_first, screen_count;
+        bool resolved;                      //screen range is valid for screen_xres/screen_yres
+        std::array<uint32_t, 6> counts;     //Context::resolved_counters the resolving replay tallied, tallied again by cached ones
+    };
+
+    void append(VertexStream const & src, std::span<const uint32_t> segments,
+                VertexFunction* const shader, math::mat4 const & matrix, uint8_t const vertices, CullFace const cull)
+    {
+        uint32_t const base = verts.size();
+        verts.resize(base + src.size());
+        verts.copy(base, src, 0, src.size());
+
+        bool const merge = !batches.empty() && batches.back().shader == shader &&
+                           (shader != nullptr || batches.back().matrix == matrix) &&
+                           batches.back().vertices == vertices && (vertices != 3 || batches.back().cull == cull);
+        if(!merge)
+        {
+            batches.push_back({base, 0, uint32_t(prims.size()), 0, shader, matrix, vertices, cull, 0, 0, false, {}});
+        }
+
+        Batch& b = batches.back();
+        uint32_t const offset = base - b.first;
+        for(uint32_t const i : segments)
+        {
+            prims.push_back(i + offset);
+        }
+        b.count += src.size();
+        b.prim_count += segments.size();
+        b.resolved = false;
+    }
+
+    VertexStream verts;
+    std::vector<uint32_t> prims;
+    std::vector<Batch> batches;
+
+    VertexStream screen;
+    uint16_t screen_xres = 0, screen_yres = 0;
 };
 
 
@@ -50,478 +660,1994 @@ class Context
 {
 public:
 
-    virtual void plot(uint16_t x, uint16_t y, uint16_t color) {};
+    //backend hooks, overridden by the backend and in async mode called from the raster thread
+    //a backend that can run async must call setAsync(false) in its own destructor, while its overrides still exist,
+    //~Context runs after the derived part is gone and asserts the thread was stopped by then
+    virtual void plot(uint16_t /*x*/, uint16_t /*y*/, uint16_t /*color*/) {};
 
-    virtual void line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) {}
-    virtual void lineHorizontal(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t color) {}
-    virtual void lineVertical(uint16_t x1, uint16_t y1, uint16_t y2, uint16_t color) {}
+    virtual void line(uint16_t /*x1*/, uint16_t /*y1*/, uint16_t /*x2*/, uint16_t /*y2*/, uint16_t /*color*/) {}
+    virtual void lineHorizontal(uint16_t /*x1*/, uint16_t /*y1*/, uint16_t /*x2*/, uint16_t /*color*/) {}
+    virtual void lineVertical(uint16_t /*x1*/, uint16_t /*y1*/, uint16_t /*y2*/, uint16_t /*color*/) {}
 
-    virtual void clear() {}
-    virtual void present() {}
+    //depth tested segment, z1 and z2 are window space depth from 0 at the near plane to 65535 at the far plane
+    //the default ignores depth
+    virtual void lineDepth(uint16_t x1, uint16_t y1, uint16_t /*z1*/, uint16_t x2, uint16_t y2, uint16_t /*z2*/, uint16_t color)
+    {
+        line(x1, y1, x2, y2, color);
+    }
+
+    //batched hook, receives every segment of a draw at once after the window transform
+    //in holds count endpoints from first on, two per segment, x and y in 16.16 window coordinates
+    //the segment takes the color of its first endpoint
+    //the default hands each segment to line(), or to lineDepth() with the z of both endpoints while depth testing
+    virtual void lines(VertexStream const & in, uint32_t const first, uint32_t const count)
+    {
+        if(depth_test)
+        {
+            for(uint32_t i = first; i + 1 < first + count; i = i + 2)
+            {
+                lineDepth(static_cast<int16_t>(math::fromRaw(in.x[i])),
+                          static_cast<int16_t>(math::fromRaw(in.y[i])),
+                          window_depth(in.z[i]),
+                          static_cast<int16_t>(math::fromRaw(in.x[i+1])),
+                          static_cast<int16_t>(math::fromRaw(in.y[i+1])),
+                          window_depth(in.z[i+1]),
+                          in.col[i]);
+            }
+            return;
+        }
+        for(uint32_t i = first; i + 1 < first + count; i = i + 2)
+        {
+            line(static_cast<int16_t>(math::fromRaw(in.x[i])),
+                 static_cast<int16_t>(math::fromRaw(in.y[i])),
+                 static_cast<int16_t>(math::fromRaw(in.x[i+1])),
+                 static_cast<int16_t>(math::fromRaw(in.y[i+1])),
+                 in.col[i]);
+        }
+    }
+
+    //batched hook for points, in holds count points from first on after the window transform, one vertex each
+    //the default hands each point to plot(), or to lineDepth() as a segment of no length while depth testing
+    virtual void points(VertexStream const & in, uint32_t const first, uint32_t const count)
+    {
+        for(uint32_t i = first; i < first + count; ++i)
+        {
+            uint16_t const x = static_cast<int16_t>(math::fromRaw(in.x[i]));
+            uint16_t const y = static_cast<int16_t>(math::fromRaw(in.y[i]));
+            if(depth_test)
+            {
+                uint16_t const z = window_depth(in.z[i]);
+                lineDepth(x, y, z, x, y, z, in.col[i]);
+            }
+            else
+            {
+                plot(x, y, in.col[i]);
+            }
+        }
+    }
+
+    //batched hook for filled triangles, in holds count vertices from first on, three per triangle, after the window transform
+    //the triangle takes the color of its first vertex and may wind either way, faces are already culled
+    //the default fills each triangle as lineHorizontal spans, covering the pixels TriangleSetup describes
+    virtual void triangles(VertexStream const & in, uint32_t const first, uint32_t const count)
+    {
+        TriangleSetup t;
+        for(uint32_t i = first; i + 2 < first + count; i = i + 3)
+        {
+            if(!t.setup(in, i, xres, yres))
+            {
+                continue;
+            }
+            for(int32_t y = t.ymin; y <= t.ymax; ++y)
+            {
+                int32_t x0, x1;
+                t.span(y, x0, x1);
+                if(x0 <= x1)
+                {
+                    lineHorizontal(x0, y, x1, t.color);
+                }
+            }
+        }
+    }
+
+    virtual void clear() {}
+    virtual void present() {}
+
+
+    Context()
+    {
+        vertex_pointer = nullptr;
+        color_pointer = nullptr;
+        index_pointer = nullptr;
+        vertex_function = nullptr;
+
+        xres = 0;
+        yres = 0;
+    }
+    //too late to stop the raster thread here, it may be inside an override of the already destroyed backend
+    //release builds still join it rather than terminate on a joinable std::thread
+    virtual ~Context()
+    {
+        assert(!async && "the backend destructor has to call setAsync(false)");
+        setAsync(false);
+    }
+
+    void setVertexFunction(VertexFunction* vf)
+    {
+        vertex_function = vf;
+    }
+
+    //waits for the raster thread in async mode
+    virtual void setViewPort(const uint16_t x, const uint16_t y)
+    {
+        Finish();
+        xres = x;
+        yres = y;
+
+        math::fixed32 const hx = math::fromRaw(int32_t(x) << 15);
+        math::fixed32 const hy = math::fromRaw(int32_t(y) << 15);
+        viewport = {{hx, -hy, 0.5_fx}, {hx, hy, 0.5_fx}};
+    }
+
+    auto width() const -> uint16_t { return xres; }
+    auto height() const -> uint16_t { return yres; }
+
+    void VertexPointer(const uint8_t size, void* pointer)
+    {
+        VertexPointer(size, ComponentType::Fixed32, 0, pointer);
+    }
+
+    //size components of type every stride bytes, stride 0 is tightly packed
+    //draws then read straight from interleaved or narrower buffers, converting while they gather
+    void VertexPointer(uint8_t const size, ComponentType const type, uint32_t const stride, void* pointer)
+    {
+        vertex_pointer = pointer;
+        vertex_size = size;
+        vertex_type = type;
+        vertex_stride = stride;
+    }
+
+    //stride is in bytes, 0 is tightly packed
+    void ColorPointer(uint16_t* pointer, uint32_t const stride = 0)
+    {
+        color_pointer = pointer;
+        color_stride = stride ? stride : sizeof(uint16_t);
+    }
+    void IndexPointer(uint8_t* pointer)
+    {
+        index_pointer = pointer;
+        index_type = IndexType::UInt8;
+    }
+    void IndexPointer(uint16_t* pointer)
+    {
+        index_pointer = pointer;
+        index_type = IndexType::UInt16;
+    }
+    void IndexPointer(uint32_t* pointer)
+    {
+        index_pointer = pointer;
+        index_type = IndexType::UInt32;
+    }
+
+    //object space bounds of the following draws, tested against the view volume under the vertex function matrix
+    //draws outside it are skipped before gather, draws inside it skip clipping
+    //only vertex functions that expose matrix() and draws without a shader callable are tested
+    void setBounds(Bounds const& b)
+    {
+        bounds = b;
+        has_bounds = true;
+    }
+
+    void clearBounds()
+    {
+        has_bounds = false;
+    }
+
+    //drops back or front facing triangles of the following draws, lines and points are never culled
+    void setCullFace(CullFace const c)
+    {
+        cull_face = c;
+    }
+
+    //drops repeated segments and joins collinear runs of the following line and point draws before clipping
+    //repeats are found by position, so they go in array draws and across indices of split vertices too
+    //the pixels a repeat drawn in the other direction would step differently are not drawn,
+    //and a merged run is stepped as one line, which may move a pixel at the joints
+    //costs a hash table probe per segment, display lists pay it once when recorded
+    //and merge only when their vertex function is a matrix
+    void setSegmentOptimization(SegmentOptimization const o)
+    {
+        segment_optimization = o;
+    }
+
+    //hidden line mode, segments and points of the following draws are depth tested against earlier ones
+    //backends without a depth buffer draw them untested, filled triangles neither test nor write depth
+    void setDepthTest(bool const enable)
+    {
+        if(async)
+        {
+            RasterCommand& c = async->ring.back();
+            c.kind = RasterCommand::Kind::DepthTest;
+            c.enable = enable;
+            async->ring.push();
+            return;
+        }
+        depth_test = enable;
+    }
+
+    //scalar type the live draws transform, clip and divide in, window space reaches the backends as 16.16 either way
+    //Float and Double take the vertex function matrix converted once per draw,
+    //shader callables that take a vec4f or vec4d run natively, others convert around each call
+    //display lists always record and replay in fixed32
+    void setPrecision(Precision const p)
+    {
+        precision_mode = p;
+    }
+
+    auto precision() const -> Precision
+    {
+        return precision_mode;
+    }
+
+    //preallocate stage buffers so the first frames do not grow them, call after setPrecision
+    void reserveVertices(uint32_t const count)
+    {
+        work.reserve(count);
+        prims.reserve(count * 2);
+        out.reserve(count * 2);
+        dispatch_scalar([&](auto s)
+        {
+            using S = typename decltype(s)::type;
+            work_stream<S>().reserve(count);
+            clipped_stream<S>().reserve(count * 2);
+        });
+    }
+
+    //the runtime entry points only dispatch on vertex_size, DrawType and the index type
+    //to the compile time specializations of draw_array and draw_elements
+    void DrawArray(DrawType drawtype, const uint32_t first, const uint32_t count)
+    {
+        if (!vertex_pointer)
+        {
+            return;
+        }
+
+        draw_type = drawtype;
+        dispatch_vertex([&](auto const vp)
+        {
+            dispatch_draw_type(drawtype, [&](auto dt)
+            {
+                draw_array<decltype(dt)::value>(vp + first, colors() + first, count, nullptr);
+            });
+        });
+    }
+
+    void DrawElements(DrawType const drawtype, uint32_t const count)
+    {
+        if (!index_pointer || !vertex_pointer)
+        {
+            return;
+        }
+
+        draw_type = drawtype;
+        dispatch_vertex([&](auto const vp)
+        {
+            dispatch_index([&](auto const* ip)
+            {
+                dispatch_draw_type(drawtype, [&](auto dt)
+                {
+                    draw_elements<decltype(dt)::value>(vp, colors(), ip, count, nullptr);
+                });
+            });
+        });
+    }
+
+    //statically dispatched variants, shader is any callable vec4(const vec4&)
+    //and is fused into the gather loop instead of going through vertex_function
+    template<class Shader>
+    void DrawArray(Shader&& shader, DrawType drawtype, const uint32_t first, const uint32_t count)
+    {
+        if (!vertex_pointer)
+        {
+            return;
+        }
+
+        draw_type = drawtype;
+        dispatch_vertex([&](auto const vp)
+        {
+            dispatch_draw_type(drawtype, [&](auto dt)
+            {
+                draw_array<decltype(dt)::value>(vp + first, colors() + first, count, shader);
+            });
+        });
+    }
+
+    template<class Shader>
+    void DrawElements(Shader&& shader, DrawType const drawtype, uint32_t const count)
+    {
+        if (!index_pointer || !vertex_pointer)
+        {
+            return;
+        }
+
+        draw_type = drawtype;
+        dispatch_vertex([&](auto const vp)
+        {
+            dispatch_index([&](auto const* ip)
+            {
+                dispatch_draw_type(drawtype, [&](auto dt)
+                {
+                    draw_elements<decltype(dt)::value>(vp, colors(), ip, count, shader);
+                });
+            });
+        });
+    }
+
+    //compile time entry points, Vec is vec2, vec3 or vec4 and DT the primitive type
+    //gather and primitive assembly compile to straight loops without per draw branches
+    //colors come from ColorPointer, indexed like verts
+    template<class Vec, DrawType DT>
+    void draw(std::span<const Vec> const verts)
+    {
+        draw_type = DT;
+        draw_array<DT>(verts.data(), colors(), verts.size(), nullptr);
+    }
+
+    template<class Vec, DrawType DT, class Index>
+    void draw(std::span<const Vec> const verts, std::span<const Index> const indices)
+    {
+        draw_type = DT;
+        draw_elements<DT>(verts.data(), colors(), indices.data(), indices.size(), nullptr);
+    }
+
+    template<class Vec, DrawType DT, class Shader>
+    void draw(Shader&& shader, std::span<const Vec> const verts)
+    {
+        draw_type = DT;
+        draw_array<DT>(verts.data(), colors(), verts.size(), shader);
+    }
+
+    template<class Vec, DrawType DT, class Index, class Shader>
+    void draw(Shader&& shader, std::span<const Vec> const verts, std::span<const Index> const indices)
+    {
+        draw_type = DT;
+        draw_elements<DT>(verts.data(), colors(), indices.data(), indices.size(), shader);
+    }
+
+    //draws between NewList and EndList are recorded into list instead of drawn
+    //the vertex function matrix is snapshotted at the draw, other vertex functions run on every CallList
+    void NewList(DisplayList& list)
+    {
+        list.clear();
+        recording = &list;
+    }
+
+    void EndList()
+    {
+        recording = nullptr;
+    }
+
+    //batches cached in window space for this viewport go straight to the backend,
+    //pipelineStats() still counts them like the replay that cached them
+    void CallList(DisplayList& list)
+    {
+        if(recording)
+        {
+            return;
+        }
+
+        if(list.screen_xres != xres || list.screen_yres != yres)
+        {
+            //window space results depend on the viewport
+            for(auto& b : list.batches)
+            {
+                b.resolved = false;
+            }
+            list.screen.resize(0);
+            list.screen_xres = xres;
+            list.screen_yres = yres;
+        }
+
+        for(auto& b : list.batches)
+        {
+            tally(&PipelineStats::draws, 1);
+            if(b.resolved)
+            {
+                for(std::size_t k = 0; k < resolved_counters.size(); ++k)
+                {
+                    tally(resolved_counters[k], b.counts[k]);
+                }
+                uint64_t const t = stage_begin();
+                run_primitive_function(b.vertices, list.screen, b.screen_first, b.screen_count);
+                stage_end(PipelineStage::Draw, t);
+                continue;
+            }
+
+            replay_batch(list, b);
+        }
+    }
+
+    //async mode hands the window space output of every draw to a raster thread through a ring of RasterCommands,
+    //so the geometry of the next frame overlaps rasterizing and presenting this one
+    //the thread makes every backend call, frames then go through Clear() and Present() instead of clear() and present()
+    //pipelineStats() and resetPipelineStats() need a Finish() first, the backend counters are written by the raster thread
+    void setAsync(bool const enable)
+    {
+        if(enable == bool(async))
+        {
+            return;
+        }
+        if(enable)
+        {
+            async = std::make_unique<AsyncRaster>();
+            async->thread = std::thread([this] { raster_loop(); });
+            return;
+        }
+        Finish();
+        async->ring.back().kind = RasterCommand::Kind::Quit;
+        async->ring.push();
+        async->thread.join();
+        async = nullptr;
+    }
+
+    auto isAsync() const -> bool
+    {
+        return bool(async);
+    }
+
+    //clear() on the raster thread in async mode, or right away
+    void Clear()
+    {
+        submit(RasterCommand::Kind::Clear);
+    }
+
+    //present() on the raster thread in async mode, or right away
+    //returns once the frame before this one is presented, so at most two frames are in flight
+    void Present()
+    {
+        submit(RasterCommand::Kind::Present);
+        if(async)
+        {
+            uint64_t const f = Fence();
+            Wait(async->previous_frame);
+            async->previous_frame = f;
+        }
+    }
+
+    //marks the commands issued so far, Wait(fence) returns once the raster thread executed all of them
+    auto Fence() -> uint64_t
+    {
+        if(!async)
+        {
+            return 0;
+        }
+        RasterCommand& c = async->ring.back();
+        c.kind = RasterCommand::Kind::Fence;
+        c.fence = ++async->issued;
+        async->ring.push();
+        return c.fence;
+    }
+
+    void Wait(uint64_t const fence)
+    {
+        if(!async)
+        {
+            return;
+        }
+        for(uint64_t f = async->completed.load(std::memory_order_acquire); f < fence; f = async->completed.load(std::memory_order_acquire))
+        {
+            async->completed.wait(f, std::memory_order_acquire);
+        }
+    }
+
+    //waits until everything issued so far is drawn
+    void Finish()
+    {
+        Wait(Fence());
+    }
+
+    using Vertex = fren::Vertex;
+
+    using StageTimes = std::array<uint64_t, static_cast<std::size_t>(PipelineStage::Count)>;
+
+    //accumulated ns per stage since the last reset, all zero unless built with FREN_STAGE_TIMING
+    auto stageTimes() const -> StageTimes const&
+    {
+        return stage_ns;
+    }
+
+    void resetStageTimes()
+    {
+        stage_ns.fill(0);
+    }
+
+    //counters since the last reset, all zero unless built with FREN_PIPELINE_STATS
+    //read and reset once per frame to get per frame numbers
+    auto pipelineStats() const -> PipelineStats const&
+    {
+        return stats;
+    }
+
+    void resetPipelineStats()
+    {
+        stats = {};
+    }
+
+protected:
+
+    uint16_t xres, yres;
+    math::Viewport<math::fixed32> viewport{};
+    void* vertex_pointer;
+    uint16_t* color_pointer;
+    void* index_pointer;
+    IndexType index_type = IndexType::UInt8;
+
+    uint8_t vertex_size;
+    ComponentType vertex_type = ComponentType::Fixed32;
+    uint32_t vertex_stride = 0;
+    uint32_t color_stride = sizeof(uint16_t);
+
+    DrawType draw_type;
+
+    VertexFunction* vertex_function;
+    DisplayList* recording = nullptr;
+
+    Bounds bounds{};
+    bool has_bounds = false;
+    CullFace cull_face = CullFace::None;
+    SegmentOptimization segment_optimization{};
+    bool depth_test = false;   //read by the backend, in async mode only written by the raster thread
+
+    //one unit of work for the raster thread, Points, Lines and Triangles own a copy of the window space stream
+    struct RasterCommand
+    {
+        enum class Kind : uint8_t
+        {
+            Points,
+            Lines,
+            Triangles,
+            Clear,
+            Present,
+            DepthTest,
+            Fence,
+            Quit
+        };
+
+        Kind kind;
+        bool enable;
+        uint64_t fence;
+        VertexStream stream;
+    };
+
+    struct AsyncRaster
+    {
+        //a full ring makes the next draw wait for the raster thread to catch up
+        //every slot allocates its stream on the first lap only
+        SpscRing<RasterCommand, 64> ring;
+        std::thread thread;
+        uint64_t issued = 0;
+        std::atomic<uint64_t> completed{0};
+        uint64_t previous_frame = 0;
+    };
+    std::unique_ptr<AsyncRaster> async;
+
+    enum class Containment : uint8_t
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    //stage buffers live on the context and are reused every draw
+    //work holds the gathered and transformed vertices, prims the assembled segments or triangles as indices into work,
+    //out the clipped segment endpoints or triangle corners which ndc and window transform then rewrite in place
+    VertexStream work;
+    std::vector<uint32_t> prims;
+    VertexStream out;
+
+    //open addressing table of the segment optimization
+    std::vector<uint32_t> hash_slot;
+
+    //work and clipped segments of the float and double pipelines, which quantize into out after the viewport
+    Precision precision_mode = Precision::Fixed;
+    BasicVertexStream<float> work_f, clipped_f;
+    BasicVertexStream<double> work_d, clipped_d;
+
+    //DrawElements transforms each referenced vertex once, elements maps every index to its slot in work
+    //slot_of/slot_stamp remember which source vertices this draw already gathered, stamped with draw_id
+    //they are indexed directly up to the larger of DIRECT_SLOTS_MIN and 4 * count, indices past that go to
+    //an open addressing table stamped the same way, so a few huge indices do not size the direct one
+    std::vector<uint32_t> elements;
+    std::vector<uint32_t> slot_of;
+    std::vector<uint32_t> slot_stamp;
+    std::vector<uint32_t> sparse_index;
+    std::vector<uint32_t> sparse_of;
+    std::vector<uint32_t> sparse_stamp;
+    uint32_t draw_id = 0;
+
+    static constexpr uint32_t DIRECT_SLOTS_MIN = 1 << 16;
+
+    StageTimes stage_ns{};
+    PipelineStats stats;
+
+    //16.16 window z, 0..1 after clipping, to the 16 bit depth lineDepth() takes
+    static auto window_depth(int32_t const z) -> uint16_t
+    {
+        return static_cast<uint16_t>(std::clamp<int32_t>(z, 0, UINT16_MAX));
+    }
+
+    //what a display list batch tallies up to its window space output, a cached replay skips that work but counts it
+    static constexpr std::array<uint64_t PipelineStats::*, 6> resolved_counters =
+    {
+        &PipelineStats::shaded, &PipelineStats::primitives, &PipelineStats::accepted,
+        &PipelineStats::clipped, &PipelineStats::rejected, &PipelineStats::discarded
+    };
+
+    void tally(uint64_t PipelineStats::* const counter, uint64_t const n)
+    {
+#if defined(FREN_PIPELINE_STATS)
+        stats.*counter += n;
+#else
+        (void)counter;
+        (void)n;
+#endif
+    }
+
+    //timers compile to nothing without FREN_STAGE_TIMING
+    //stage_end returns the current time so consecutive stages share one clock read
+    auto stage_begin() const -> uint64_t
+    {
+#if defined(FREN_STAGE_TIMING)
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        return 0;
+#endif
+    }
+
+    auto stage_end(PipelineStage const stage, uint64_t const begin) -> uint64_t
+    {
+#if defined(FREN_STAGE_TIMING)
+        uint64_t const now = stage_begin();
+        stage_ns[static_cast<std::size_t>(stage)] += now - begin;
+        return now;
+#else
+        (void)stage;
+        return begin;
+#endif
+    }
+
+    //tightly packed fixed32 is read through vec2/3/4 pointers, everything else through StridedVertices
+    template<class F>
+    void dispatch_vertex(F&& f)
+    {
+        if(vertex_type == ComponentType::Fixed32 && (vertex_stride == 0 || vertex_stride == vertex_size * sizeof(math::fixed32)))
+        {
+            if(vertex_size == 2)
+            {
+                f(static_cast<math::vec2 const*>(vertex_pointer));
+            }
+            else if(vertex_size == 3)
+            {
+                f(static_cast<math::vec3 const*>(vertex_pointer));
+            }
+            else if(vertex_size == 4)
+            {
+                f(static_cast<math::vec4 const*>(vertex_pointer));
+            }
+            return;
+        }
+
+        switch(vertex_type)
+        {
+        case ComponentType::Int8: dispatch_strided<int8_t>(f); break;
+        case ComponentType::Int16: dispatch_strided<int16_t>(f); break;
+        case ComponentType::Fixed32: dispatch_strided<int32_t>(f); break;
+        case ComponentType::Float: dispatch_strided<float>(f); break;
+        }
+    }
+
+    template<class T, class F>
+    void dispatch_strided(F&& f)
+    {
+        uint8_t const* const base = static_cast<uint8_t const*>(vertex_pointer);
+        uint32_t const stride = vertex_stride ? vertex_stride : vertex_size * sizeof(T);
+        if(vertex_size == 2)
+        {
+            f(StridedVertices<T, 2>{base, stride});
+        }
+        else if(vertex_size == 3)
+        {
+            f(StridedVertices<T, 3>{base, stride});
+        }
+        else if(vertex_size == 4)
+        {
+            f(StridedVertices<T, 4>{base, stride});
+        }
+    }
+
+    auto colors() const -> StridedColors
+    {
+        return {reinterpret_cast<uint8_t const*>(color_pointer), color_stride};
+    }
+
+    template<class F>
+    void dispatch_index(F&& f)
+    {
+        if(index_type == IndexType::UInt8)
+        {
+            f(static_cast<uint8_t const*>(index_pointer));
+        }
+        else if(index_type == IndexType::UInt16)
+        {
+            f(static_cast<uint16_t const*>(index_pointer));
+        }
+        else
+        {
+            f(static_cast<uint32_t const*>(index_pointer));
+        }
+    }
+
+    template<DrawType DT>
+    using DrawTypeConstant = std::integral_constant<DrawType, DT>;
+
+    template<class F>
+    static void dispatch_draw_type(DrawType const dt, F&& f)
+    {
+        switch(dt)
+        {
+        case DrawType::Points: f(DrawTypeConstant<DrawType::Points>{}); break;
+        case DrawType::Lines: f(DrawTypeConstant<DrawType::Lines>{}); break;
+        case DrawType::Line_Strip: f(DrawTypeConstant<DrawType::Line_Strip>{}); break;
+        case DrawType::Line_Loop: f(DrawTypeConstant<DrawType::Line_Loop>{}); break;
+        case DrawType::Triangles: f(DrawTypeConstant<DrawType::Triangles>{}); break;
+        case DrawType::Triangle_Strip: f(DrawTypeConstant<DrawType::Triangle_Strip>{}); break;
+        case DrawType::Triangle_Fan: f(DrawTypeConstant<DrawType::Triangle_Fan>{}); break;
+        }
+    }
+
+    template<DrawType DT>
+    static constexpr bool filled = DT == DrawType::Triangles || DT == DrawType::Triangle_Strip || DT == DrawType::Triangle_Fan;
+
+    //indices per assembled primitive in prims
+    template<DrawType DT>
+    static constexpr uint8_t prim_vertices = filled<DT> ? 3 : DT == DrawType::Points ? 1 : 2;
+
+    //lists record fixed32, precision only applies to live draws
+    template<class F>
+    void dispatch_scalar(F&& f)
+    {
+        if(recording || precision_mode == Precision::Fixed)
+        {
+            f(std::type_identity<math::fixed32>{});
+        }
+        else if(precision_mode == Precision::Float)
+        {
+            f(std::type_identity<float>{});
+        }
+        else
+        {
+            f(std::type_identity<double>{});
+        }
+    }
+
+    template<math::Scalar S>
+    auto work_stream() -> BasicVertexStream<S>&
+    {
+        if constexpr (std::is_same_v<S, float>)
+        {
+            return work_f;
+        }
+        else if constexpr (std::is_same_v<S, double>)
+        {
+            return work_d;
+        }
+        else
+        {
+            return work;
+        }
+    }
+
+    //fixed32 clips straight into out and runs ndc and viewport there
+    template<math::Scalar S>
+    auto clipped_stream() -> BasicVertexStream<S>&
+    {
+        if constexpr (std::is_same_v<S, float>)
+        {
+            return clipped_f;
+        }
+        else if constexpr (std::is_same_v<S, double>)
+        {
+            return clipped_d;
+        }
+        else
+        {
+            return out;
+        }
+    }
+
+    static auto homogeneous(math::vec2 const& v) -> math::vec4
+    {
+        return {v.x, v.y, 0.0_fx, 1.0_fx};
+    }
+
+    static auto homogeneous(math::vec3 const& v) -> math::vec4
+    {
+        return {v.x, v.y, v.z, 1.0_fx};
+    }
+
+    static auto homogeneous(math::vec4 const& v) -> math::vec4
+    {
+        return v;
+    }
+
+    template<math::Scalar S, class Vec>
+    static auto fetch(Vec const* const vp, uint32_t const i) -> math::basic_vec4<S>
+    {
+        return math::cast<S>(homogeneous(vp[i]));
+    }
+
+    template<math::Scalar S, class T, uint8_t N>
+    static auto fetch(StridedVertices<T, N> const& vp, uint32_t const i) -> math::basic_vec4<S>
+    {
+        return vp.template get<S>(i);
+    }
+
+    //nullptr leaves the vertex for vertex_function, anything else is a shader callable
+    template<class Shade>
+    static constexpr bool fused = !std::is_null_pointer_v<std::remove_cvref_t<Shade>>;
+
+    template<math::Scalar S, class Shade>
+    static auto shade_vertex([[maybe_unused]] Shade& shade, math::basic_vec4<S> const& v) -> math::basic_vec4<S>
+    {
+        if constexpr (!fused<Shade>)
+        {
+            return v;
+        }
+        else if constexpr (std::is_invocable_v<Shade&, math::basic_vec4<S> const&>)
+        {
+            return shade(v);
+        }
+        else
+        {
+            return math::cast<S>(shade(math::cast<math::fixed32>(v)));
+        }
+    }
+
+    //Verts is a vec2/3/4 pointer or a StridedVertices, fetch() reads either
+    template<DrawType DT, class Verts, class Shade>
+    void draw_array(Verts const vp, StridedColors const cp, uint32_t const count, Shade&& shade)
+    {
+        dispatch_scalar([&](auto s)
+        {
+            gather_array<DT, typename decltype(s)::type>(vp, cp, count, shade);
+        });
+    }
+
+    template<DrawType DT, class Verts, class Index, class Shade>
+    void draw_elements(Verts const vp, StridedColors const cp, Index const* const ip, uint32_t const count, Shade&& shade)
+    {
+        dispatch_scalar([&](auto s)
+        {
+            gather_elements<DT, typename decltype(s)::type>(vp, cp, ip, count, shade);
+        });
+    }
+
+    template<DrawType DT, math::Scalar S, class Verts, class Shade>
+    void gather_array(Verts const vp, StridedColors const cp, uint32_t const count, Shade& shade)
+    {
+        uint64_t const t = stage_begin();
+        tally(&PipelineStats::draws, 1);
+        Containment const bound = test_bounds<fused<Shade>>();
+        if(bound == Containment::Outside)
+        {
+            return;
+        }
+        tally(&PipelineStats::vertices, count);
+        tally(&PipelineStats::shaded, count);
+
+        //gather pos into buffer, resize keeps capacity so steady state does not allocate
+        BasicVertexStream<S>& work = work_stream<S>();
+        work.resize(count);
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            work.set(i, shade_vertex<S>(shade, fetch<S>(vp, i)));
+        }
+
+        //gather col into buffer
+        if(cp && cp.stride == sizeof(uint16_t))
+        {
+            uint16_t const* const packed = reinterpret_cast<uint16_t const*>(cp.base);
+            std::copy(packed, packed + count, work.col.begin());
+        }
+        else if(cp)
+        {
+            for(uint32_t i = 0; i < count; ++i)
+            {
+                work.col[i] = cp[i];
+            }
+        }
+        else
+        {
+            std::fill(work.col.begin(), work.col.end(), UINT16_MAX);
+        }
+
+        draw_gathered<DT, false, fused<Shade>, S>(bound == Containment::Inside, stage_end(fused<Shade> ? PipelineStage::Vertex : PipelineStage::Gather, t));
+    }
+
+    //dedups the index list into work, repeated indices share one transformed vertex
+    template<DrawType DT, math::Scalar S, class Verts, class Index, class Shade>
+    void gather_elements(Verts const vp, StridedColors const cp, Index const* const ip, uint32_t const count, Shade& shade)
+    {
+        uint64_t const t = stage_begin();
+        Containment const bound = test_bounds<fused<Shade>>();
+        if(bound == Containment::Outside)
+        {
+            tally(&PipelineStats::draws, 1);
+            return;
+        }
+
+        if(++draw_id == 0)
+        {
+            std::fill(slot_stamp.begin(), slot_stamp.end(), 0);
+            std::fill(sparse_stamp.begin(), sparse_stamp.end(), 0);
+            draw_id = 1;
+        }
+
+        BasicVertexStream<S>& work = work_stream<S>();
+        elements.resize(count);
+        work.resize(count);
+        uint32_t unique = 0;
+        uint32_t const direct = static_cast<uint32_t>(std::min<uint64_t>(UINT32_MAX, std::max<uint64_t>(DIRECT_SLOTS_MIN, uint64_t(count) * 4)));
+
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t const index = ip[i];
+            uint32_t* stamp;
+            uint32_t* slot;
+            if(index < slot_stamp.size() || index < direct)
+            {
+                if(index >= slot_stamp.size())
+                {
+                    slot_stamp.resize(index + 1, 0);
+                    slot_of.resize(index + 1);
+                }
+                stamp = &slot_stamp[index];
+                slot = &slot_of[index];
+            }
+            else
+            {
+                //at most count entries per draw in a table of at least 2 * count, sized by the first draw that needs it
+                if(sparse_stamp.size() < std::bit_ceil(count * 2))
+                {
+                    sparse_stamp.assign(std::bit_ceil(count * 2), 0);
+                    sparse_index.resize(sparse_stamp.size());
+                    sparse_of.resize(sparse_stamp.size());
+                }
+                uint32_t const mask = sparse_stamp.size() - 1;
+                uint32_t s = static_cast<uint32_t>(index * 0x9E3779B97F4A7C15ull >> 32) & mask;
+                while(sparse_stamp[s] == draw_id && sparse_index[s] != index)
+                {
+                    s = (s + 1) & mask;
+                }
+                sparse_index[s] = index;
+                stamp = &sparse_stamp[s];
+                slot = &sparse_of[s];
+            }
+            if(*stamp != draw_id)
+            {
+                *stamp = draw_id;
+                *slot = unique;
+                work.set(unique, shade_vertex<S>(shade, fetch<S>(vp, index)));
+                work.col[unique] = cp ? cp[index] : UINT16_MAX;
+                ++unique;
+            }
+            elements[i] = *slot;
+        }
+
+        work.resize(unique);
+        tally(&PipelineStats::draws, 1);
+        tally(&PipelineStats::vertices, count);
+        tally(&PipelineStats::shaded, unique);
+
+        draw_gathered<DT, true, fused<Shade>, S>(bound == Containment::Inside, stage_end(fused<Shade> ? PipelineStage::Vertex : PipelineStage::Gather, t));
+    }
+
+    //everything after gather, Shaded draws already ran their shader in the gather loop
+    //inside draws were shown by their bounds to need no clipping
+    template<DrawType DT, bool Indexed, bool Shaded, math::Scalar S>
+    void draw_gathered(bool const inside, uint64_t t)
+    {
+        BasicVertexStream<S>& work = work_stream<S>();
+        if constexpr (std::is_same_v<S, math::fixed32>)
+        {
+            if(recording)
+            {
+                //a fused shader already ran, the list keeps the result under an identity matrix
+                assemble_prims<DT, Indexed>(work.size());
+                if constexpr (!filled<DT>)
+                {
+                    //collinear before the vertex function stays collinear after it only for a matrix
+                    bool const linear = Shaded || vertex_function == nullptr || vertex_function->matrix();
+                    optimize_segments<prim_vertices<DT>>(work, linear);
+                }
+                stage_end(PipelineStage::Lines, t);
+                record_draw(Shaded ? nullptr : vertex_function, prim_vertices<DT>);
+                return;
+            }
+        }
+
+        if constexpr (!Shaded)
+        {
+            run_vertex_function(work);
+            t = stage_end(PipelineStage::Vertex, t);
+        }
+        if(!inside)
+        {
+            run_outcode_function(work);
+            t = stage_end(PipelineStage::Clip, t);
+        }
+        assemble_prims<DT, Indexed>(work.size());
+        if constexpr (!filled<DT>)
+        {
+            optimize_segments<prim_vertices<DT>>(work, true);
+        }
+        t = stage_end(PipelineStage::Lines, t);
+        if constexpr (filled<DT>)
+        {
+            t = triangle_pipeline<S>(prims, cull_face, t, inside);
+            run_triangle_function(out, 0, out.size());
+        }
+        else if constexpr (DT == DrawType::Points)
+        {
+            t = point_pipeline<S>(prims, t, inside);
+            run_point_function(out, 0, out.size());
+        }
+        else
+        {
+            t = segment_pipeline<S>(prims, t, inside);
+            run_draw_function(out, 0, out.size());
+        }
+        stage_end(PipelineStage::Draw, t);
+    }
+
+    template<DrawType DT, bool Indexed>
+    void assemble_prims(uint32_t const gathered)
+    {
+        if constexpr (filled<DT> && Indexed)
+        {
+            assemble_triangles<DT>(elements.size(), [this](uint32_t const i) { return elements[i]; }, prims);
+        }
+        else if constexpr (filled<DT>)
+        {
+            assemble_triangles<DT>(gathered, [](uint32_t const i) { return i; }, prims);
+        }
+        else if constexpr (Indexed)
+        {
+            assemble_lines<DT>(elements.size(), [this](uint32_t const i) { return elements[i]; }, prims);
+        }
+        else
+        {
+            assemble_lines<DT>(gathered, [](uint32_t const i) { return i; }, prims);
+        }
+    }
+
+    //writes each triangle as three indices into work, its first vertex gives the color
+    //strips swap the last two corners of every other triangle to keep the winding,
+    //fans start each triangle at its outer vertex i + 1 and wind like (0, i + 1, i + 2)
+    template<DrawType DT, class Elem>
+    static void assemble_triangles(uint32_t const n, Elem const elem, std::vector<uint32_t>& out)
+    {
+        if constexpr (DT == DrawType::Triangles)
+        {
+            out.resize(n - n % 3);
+            for(uint32_t i = 0; i < out.size(); ++i)
+            {
+                out[i] = elem(i);
+            }
+        }
+        else
+        {
+            if(n < 3)
+            {
+                out.clear();
+                return;
+            }
+
+            out.resize((n - 2) * 3);
+            for(uint32_t i = 0; i < n - 2; ++i)
+            {
+                if constexpr (DT == DrawType::Triangle_Strip)
+                {
+                    out[i * 3] = elem(i);
+                    out[i * 3 + 1] = elem(i & 1 ? i + 2 : i + 1);
+                    out[i * 3 + 2] = elem(i & 1 ? i + 1 : i + 2);
+                }
+                else
+                {
+                    out[i * 3] = elem(i + 1);
+                    out[i * 3 + 1] = elem(i + 2);
+                    out[i * 3 + 2] = elem(0);
+                }
+            }
+        }
+    }
+
+    //primitive assembly, writes each segment as a pair of indices into work and each point as one
+    //elem maps draw order to work slots
+    template<DrawType DT, class Elem>
+    static void assemble_lines(uint32_t const n, Elem const elem, std::vector<uint32_t>& out)
+    {
+        if constexpr (DT == DrawType::Points)
+        {
+            out.resize(n);
+            for(uint32_t i = 0; i < n; ++i)
+            {
+                out[i] = elem(i);
+            }
+        }
+        else if constexpr (DT == DrawType::Lines)
+        {
+            out.resize(n & ~1u);
+            for(uint32_t i = 0; i < out.size(); ++i)
+            {
+                out[i] = elem(i);
+            }
+        }
+        else
+        {
+            if(n < 2)
+            {
+                out.clear();
+                return;
+            }
+
+            uint32_t const segments = (DT == DrawType::Line_Loop) ? n : n - 1;
+            out.resize(segments * 2);
+            for(uint32_t i = 0; i < n - 1; ++i)
+            {
+                out[i * 2] = elem(i);
+                out[i * 2 + 1] = elem(i + 1);
+            }
+            if constexpr (DT == DrawType::Line_Loop)
+            {
+                out[(n - 1) * 2] = elem(n - 1);
+                out[(n - 1) * 2 + 1] = elem(0);
+            }
+        }
+    }
+
+    //rewrites prims of N indices per point or segment in place, keeping the order of the ones that stay
+    //merging compares clip space positions, so it is only exact on positions a linear map takes to clip space
+    template<uint8_t N, math::Scalar S>
+    void optimize_segments(BasicVertexStream<S> const & in, bool const linear)
+    {
+        uint32_t const count = prims.size() / N;
+        if(count == 0 || !(segment_optimization.dedup || segment_optimization.merge))
+        {
+            return;
+        }
+
+        //keyed by both endpoint positions in either order and the color of the first endpoint,
+        //the table holds the kept segment each key first came with
+        uint32_t kept = count;
+        if(segment_optimization.dedup)
+        {
+            auto const repeats = [&](uint32_t const k, uint32_t const a, uint32_t const b)
+            {
+                uint32_t const ka = prims[k * N];
+                uint32_t const kb = prims[k * N + N - 1];
+                return in.col[ka] == in.col[a] &&
+                       ((same_position(in, ka, a) && same_position(in, kb, b)) || (same_position(in, ka, b) && same_position(in, kb, a)));
+            };
+            uint32_t const mask = std::bit_ceil(count * 2) - 1;
+            hash_slot.assign(mask + 1, UINT32_MAX);
+            kept = 0;
+            for(uint32_t i = 0; i < count; ++i)
+            {
+                //a point is keyed like a segment from it to itself
+                uint32_t const a = prims[i * N];
+                uint32_t const b = prims[i * N + N - 1];
+                uint32_t s = segment_hash(position_hash(in, a), position_hash(in, b), in.col[a]) & mask;
+                while(hash_slot[s] != UINT32_MAX && !repeats(hash_slot[s], a, b))
+                {
+                    s = (s + 1) & mask;
+                }
+                if(hash_slot[s] != UINT32_MAX)
+                {
+                    continue;
+                }
+                hash_slot[s] = kept;
+                prims[kept * N] = a;
+                prims[kept * N + N - 1] = b;
+                ++kept;
+            }
+        }
+
+        //a segment starting where the one before it ends, in its color and direction, extends it
+        uint32_t o = kept;
+        if constexpr (N == 2)
+        {
+            if(segment_optimization.merge && linear)
+            {
+                o = 0;
+                for(uint32_t i = 0; i < kept; ++i)
+                {
+                    uint32_t const a = prims[i * 2];
+                    uint32_t const b = prims[i * 2 + 1];
+                    if(o > 0)
+                    {
+                        uint32_t const pa = prims[o * 2 - 2];
+                        uint32_t const pb = prims[o * 2 - 1];
+                        if(in.col[pa] == in.col[a] && same_position(in, pb, a) && continues(in, pa, pb, b))
+                        {
+                            prims[o * 2 - 1] = b;
+                            continue;
+                        }
+                    }
+                    prims[o * 2] = a;
+                    prims[o * 2 + 1] = b;
+                    ++o;
+                }
+            }
+        }
 
+        prims.resize(o * N);
+        tally(&PipelineStats::deduplicated, count - kept);
+        tally(&PipelineStats::merged, kept - o);
+    }
 
-    Context()
+    template<math::Scalar S>
+    static auto lane_bits(typename BasicVertexStream<S>::Lane const v) -> uint64_t
     {
-        vertex_pointer = nullptr;
-        color_pointer = nullptr;
-        index_pointer = nullptr;
-        vertex_function = nullptr;
-
-        xres = 0;
-        yres = 0;
+        using Bits = std::conditional_t<sizeof(v) == 8, uint64_t, uint32_t>;
+        return std::bit_cast<Bits>(v);
     }
-    virtual ~Context()
-    {
 
+    //the lanes times odd constants, summed per segment and folded to a slot by the high half of one more product
+    template<math::Scalar S>
+    static auto position_hash(BasicVertexStream<S> const & in, uint32_t const v) -> uint64_t
+    {
+        uint64_t const h = lane_bits<S>(in.x[v]) * 0x9E3779B97F4A7C15ull ^ lane_bits<S>(in.y[v]) * 0xC2B2AE3D27D4EB4Full ^
+                           lane_bits<S>(in.z[v]) * 0x165667B19E3779F9ull ^ lane_bits<S>(in.w[v]) * 0xD6E8FEB86659FD93ull;
+        return h ^ (h >> 29);
     }
 
-    void setVertexFunction(VertexFunction* vf)
+    static auto segment_hash(uint64_t const a, uint64_t const b, uint16_t const color) -> uint32_t
     {
-        vertex_function = vf;
+        return static_cast<uint32_t>(((a + b) ^ color) * 0xFF51AFD7ED558CCDull >> 32);
     }
 
-    void setViewPort(const uint16_t x, const uint16_t y)
+    //compared bitwise like they are hashed, so -0 and 0 are two positions
+    template<math::Scalar S>
+    static auto same_position(BasicVertexStream<S> const & in, uint32_t const a, uint32_t const b) -> bool
     {
-        xres = x;
-        yres = y;
+        return lane_bits<S>(in.x[a]) == lane_bits<S>(in.x[b]) && lane_bits<S>(in.y[a]) == lane_bits<S>(in.y[b]) &&
+               lane_bits<S>(in.z[a]) == lane_bits<S>(in.z[b]) && lane_bits<S>(in.w[a]) == lane_bits<S>(in.w[b]);
     }
 
-    void VertexPointer(const uint8_t size, void* pointer)
+    //whether c lies past b on the ray from a through b, so a to c covers a to b and b to c
+    //fixed32 tests exactly in 64 bit and gives up on steps of 2^15 or more
+    template<math::Scalar S>
+    static auto continues(BasicVertexStream<S> const & in, uint32_t const a, uint32_t const b, uint32_t const c) -> bool
     {
-        vertex_pointer = pointer;
-        vertex_size = size;
+        using Wide = std::conditional_t<std::is_same_v<S, math::fixed32>, int64_t, double>;
+        Wide const u[4] = {Wide(in.x[b]) - Wide(in.x[a]), Wide(in.y[b]) - Wide(in.y[a]),
+                           Wide(in.z[b]) - Wide(in.z[a]), Wide(in.w[b]) - Wide(in.w[a])};
+        Wide const v[4] = {Wide(in.x[c]) - Wide(in.x[b]), Wide(in.y[c]) - Wide(in.y[b]),
+                           Wide(in.z[c]) - Wide(in.z[b]), Wide(in.w[c]) - Wide(in.w[b])};
+        if constexpr (std::is_same_v<Wide, int64_t>)
+        {
+            for(uint32_t i = 0; i < 4; ++i)
+            {
+                if(u[i] <= INT32_MIN || u[i] >= INT32_MAX || v[i] <= INT32_MIN || v[i] >= INT32_MAX)
+                {
+                    return false;
+                }
+            }
+        }
+
+        //parallel when every 2d cross product is zero, then every u[i] * v[i] has the sign of the scale between them
+        bool forward = false;
+        for(uint32_t i = 0; i < 4; ++i)
+        {
+            for(uint32_t j = i + 1; j < 4; ++j)
+            {
+                if(u[i] * v[j] != u[j] * v[i])
+                {
+                    return false;
+                }
+            }
+            forward |= u[i] * v[i] > 0;
+        }
+        return forward;
     }
-    void ColorPointer(uint16_t* pointer)
+
+    //clip, ndc and window transform of the segments in work into out
+    template<math::Scalar S>
+    auto segment_pipeline(std::span<const uint32_t> const segments, uint64_t t, bool const inside = false) -> uint64_t
     {
-        color_pointer = pointer;
+        BasicVertexStream<S>& clipped = clipped_stream<S>();
+        if(inside)
+        {
+            run_accept_function<2>(work_stream<S>(), segments, clipped);
+        }
+        else
+        {
+            run_clip_function(work_stream<S>(), segments, clipped);
+        }
+        t = stage_end(PipelineStage::Clip, t);
+        run_ndc_function(clipped);
+        t = stage_end(PipelineStage::Ndc, t);
+        if constexpr (!std::is_same_v<S, math::fixed32>)
+        {
+            run_quantize_function(clipped, out);
+        }
+        return stage_end(PipelineStage::Viewport, t);
     }
-    void IndexPointer(uint8_t* pointer)
+
+    //the same for points, which are only tested against the view volume and divided once each
+    template<math::Scalar S>
+    auto point_pipeline(std::span<const uint32_t> const points, uint64_t t, bool const inside = false) -> uint64_t
     {
-        index_pointer = pointer;
+        BasicVertexStream<S>& clipped = clipped_stream<S>();
+        if(inside)
+        {
+            run_accept_function<1>(work_stream<S>(), points, clipped);
+        }
+        else
+        {
+            run_clip_points(work_stream<S>(), points, clipped);
+        }
+        t = stage_end(PipelineStage::Clip, t);
+        run_ndc_function(clipped);
+        t = stage_end(PipelineStage::Ndc, t);
+        if constexpr (!std::is_same_v<S, math::fixed32>)
+        {
+            run_quantize_function(clipped, out);
+        }
+        return stage_end(PipelineStage::Viewport, t);
     }
 
-    void DrawArray(DrawType drawtype, const uint32_t first, const uint32_t count)
+    //the same for triangles, which are culled once they are in window space
+    template<math::Scalar S>
+    auto triangle_pipeline(std::span<const uint32_t> const triangles, CullFace const cull, uint64_t t, bool const inside = false) -> uint64_t
     {
-        if (!vertex_pointer)
+        BasicVertexStream<S>& clipped = clipped_stream<S>();
+        if(inside)
         {
-            return;
+            run_accept_function<3>(work_stream<S>(), triangles, clipped);
+        }
+        else
+        {
+            run_clip_triangles(work_stream<S>(), triangles, clipped);
+        }
+        t = stage_end(PipelineStage::Clip, t);
+        run_ndc_function(clipped);
+        t = stage_end(PipelineStage::Ndc, t);
+        if constexpr (!std::is_same_v<S, math::fixed32>)
+        {
+            run_quantize_function(clipped, out);
         }
+        t = stage_end(PipelineStage::Viewport, t);
+        run_cull_function(out, cull);
+        return stage_end(PipelineStage::Clip, t);
+    }
 
-        draw_type = drawtype;
+    //appends the gathered and assembled draw to the list being recorded
+    void record_draw(VertexFunction* const vf, uint8_t const vertices)
+    {
+        math::mat4 const* m = vf ? vf->matrix() : nullptr;
+        if(vf == nullptr || m != nullptr)
+        {
+            recording->append(work, prims, nullptr, m ? *m : math::identity(), vertices, cull_face);
+        }
+        else
+        {
+            recording->append(work, prims, vf, math::identity(), vertices, cull_face);
+        }
+    }
 
-        //gather pos into buffer
-        work_buff.clear();
+    //runs one batch of a list from its gathered vertices, matrix batches keep the result for the next call
+    void replay_batch(DisplayList& list, DisplayList::Batch& b)
+    {
+        PipelineStats const before = stats;
+        uint64_t t = stage_begin();
+        work.resize(b.count);
+        work.copy(0, list.verts, b.first, b.count);
+        tally(&PipelineStats::shaded, b.count);
+        t = stage_end(PipelineStage::Gather, t);
+
+        if(b.shader)
+        {
+            VertexFunction* const vf = vertex_function;
+            vertex_function = b.shader;
+            run_vertex_function(work);
+            vertex_function = vf;
+        }
+        else
+        {
+            math::transform(b.matrix, work.x.data(), work.y.data(), work.z.data(), work.w.data(), work.padded());
+        }
+        t = stage_end(PipelineStage::Vertex, t);
 
-        if(vertex_size == 2)
+        run_outcode_function(work);
+        t = stage_end(PipelineStage::Clip, t);
+        std::span<const uint32_t> const batch_prims = std::span<const uint32_t>(list.prims).subspan(b.prim_first, b.prim_count);
+        if(b.vertices == 3)
         {
-            fren::math::vec2* vp = reinterpret_cast<fren::math::vec2*>(vertex_pointer);
-            auto ggg = vp[0].y;
-            for(uint32_t i = first ;i < count; ++i)
-            {
-                work_buff.push_back( Vertex{ {vp[i].x, vp[i].y,0.0_fx,1.0_fx}, UINT16_MAX } );
-            }
+            t = triangle_pipeline<math::fixed32>(batch_prims, b.cull, t);
         }
-        else if(vertex_size == 3)
+        else if(b.vertices == 1)
         {
-            fren::math::vec3* vp = reinterpret_cast<fren::math::vec3*>(vertex_pointer);
-            for(uint32_t i = first ;i < count; ++i)
-            {
-                work_buff.push_back( Vertex{ {vp[i].x, vp[i].y,vp[i].z,1.0_fx}, UINT16_MAX } );
-            }
+            t = point_pipeline<math::fixed32>(batch_prims, t);
         }
-        else if(vertex_size == 4)
+        else
         {
-            fren::math::vec4* vp = reinterpret_cast<fren::math::vec4*>(vertex_pointer);
-            for(uint32_t i = first ;i < count; ++i)
-            {
-                work_buff.push_back( Vertex{ vp[i], UINT16_MAX } );
-            }
+            t = segment_pipeline<math::fixed32>(batch_prims, t);
         }
 
-        //gather col into buffer
-        if(color_pointer)
+        if(!b.shader)
         {
-            uint16_t* cp = color_pointer;
-            for(uint32_t i = first; i < count; ++i)
+            b.screen_first = list.screen.size();
+            b.screen_count = out.size();
+            list.screen.resize(b.screen_first + b.screen_count);
+            list.screen.copy(b.screen_first, out, 0, b.screen_count);
+            b.resolved = true;
+            for(std::size_t k = 0; k < resolved_counters.size(); ++k)
             {
-                work_buff[i].col = cp[i];
+                b.counts[k] = static_cast<uint32_t>(stats.*resolved_counters[k] - before.*resolved_counters[k]);
             }
         }
 
-        vertex_pipeline();
+        run_primitive_function(b.vertices, out, 0, out.size());
+        stage_end(PipelineStage::Draw, t);
     }
 
-    void DrawElements(DrawType const drawtype, uint32_t const count)
+    template<math::Scalar S>
+    void run_vertex_function(BasicVertexStream<S>& in)
     {
-        if (!index_pointer || !vertex_pointer)
+        if(const math::mat4* m = vertex_function->matrix())
         {
+            math::transform(math::cast<S>(*m), in.x.data(), in.y.data(), in.z.data(), in.w.data(), in.padded());
             return;
         }
 
-        draw_type = drawtype;
-
-        //gather pos into buffer
-        work_buff.clear();
-
-        if(vertex_size == 2)
-        {
-            fren::math::vec2* vp = reinterpret_cast<fren::math::vec2*>(vertex_pointer);
-            for(uint32_t i = 0 ;i < count; ++i)
-            {
-                work_buff.push_back( Vertex{ {vp[index_pointer[i]].x,vp[index_pointer[i]].y, 0.0_fx, 1.0_fx} , UINT16_MAX } );
-            }
-        }
-        else if(vertex_size == 3)
+        //arbitrary shaders get their batch call on small aos chunks
+        std::array<Vertex, 64> chunk;
+        for(uint32_t base = 0; base < in.size(); base += chunk.size())
         {
-            fren::math::vec3* vp = reinterpret_cast<fren::math::vec3*>(vertex_pointer);
-            for(uint32_t i = 0 ;i < count; ++i)
+            uint32_t const n = std::min<uint32_t>(chunk.size(), in.size() - base);
+            for(uint32_t i = 0; i < n; ++i)
             {
-                work_buff.push_back( Vertex{ {vp[index_pointer[i]].x, vp[index_pointer[i]].y, vp[index_pointer[i]].z, 1.0_fx} , UINT16_MAX } );
+                chunk[i].pos = math::cast<math::fixed32>(in.get(base + i));
             }
-        }
-        else if(vertex_size == 4)
-        {
-            fren::math::vec4* vp = reinterpret_cast<fren::math::vec4*>(vertex_pointer);
-            for(uint32_t i = 0 ;i < count; ++i)
+            vertex_function->transform(std::span<Vertex>(chunk.data(), n));
+            for(uint32_t i = 0; i < n; ++i)
             {
-                work_buff.push_back( Vertex{ {vp[index_pointer[i]]} , UINT16_MAX } );
+                in.set(base + i, math::cast<S>(chunk[i].pos));
             }
         }
+    }
 
-        //gather col into buffer
-        if(color_pointer)
+    //once per vertex, before primitive assembly references them
+    template<math::Scalar S>
+    void run_outcode_function(BasicVertexStream<S>& in)
+    {
+        for(uint32_t i = 0; i < in.size(); ++i)
         {
-            uint16_t* cp = color_pointer;
-            for(uint32_t i = 0; i < count; ++i)
-            {
-                work_buff[i].col = cp[index_pointer[i]];
-            }
+            in.clip[i] = outcode(in.x[i], in.y[i], in.z[i], in.w[i]);
         }
-
-        vertex_pipeline();
     }
 
-    struct Vertex
+    template<class Lane>
+    static auto outcode(Lane const x, Lane const y, Lane const z, Lane const w) -> uint8_t
     {
-        fren::math::vec4 pos;
-        uint16_t col;
-    };
-
-protected:
-
-    uint16_t xres, yres;
-    void* vertex_pointer;
-    uint16_t* color_pointer;
-    uint8_t* index_pointer;
-
-    uint8_t vertex_size;
-
-    DrawType draw_type;
-
-    VertexFunction* vertex_function;
-
-    std::vector<Vertex> work_buff;
-
+        return (x > w ? ClipRight : 0) |
+               (x < -w ? ClipLeft : 0) |
+               (y > w ? ClipTop : 0) |
+               (y < -w ? ClipBottom : 0) |
+               (z > w ? ClipFar : 0) |
+               (z < -w ? ClipNear : 0);
+    }
 
-    std::vector<Vertex> convert_to_lines(std::vector<Vertex>& in, DrawType dt)
+    //transforms the corners of bounds, outside when all of them are outside one plane
+    //inside needs every corner a few ulps within w, the matrix rounds vertices inside the box by up to one
+    template<bool Shaded>
+    auto test_bounds() -> Containment
     {
-        std::vector<Vertex> out;
+        if constexpr (Shaded)
+        {
+            return Containment::Intersecting;
+        }
+        //lists may be recorded without a vertex function, like record_draw those draws are not tested
+        math::mat4 const* const m = has_bounds && vertex_function ? vertex_function->matrix() : nullptr;
+        if(!m)
+        {
+            return Containment::Intersecting;
+        }
 
-        if(dt == DrawType::Points)
+        constexpr int32_t margin = 4;
+        uint8_t all = UINT8_MAX;
+        uint8_t any = 0;
+        for(uint8_t i = 0; i < 8; ++i)
         {
-            for(uint8_t i = 0; i  <in.size(); ++i)
-            {
-                out.push_back(in[i]);
-                out.push_back(in[i]);
-            }
+            math::vec4 const c = (*m) * math::vec4{i & 1 ? bounds.max.x : bounds.min.x,
+                                                   i & 2 ? bounds.max.y : bounds.min.y,
+                                                   i & 4 ? bounds.max.z : bounds.min.z,
+                                                   1.0_fx};
+            all &= outcode(c.x.data, c.y.data, c.z.data, c.w.data);
+            any |= outcode(c.x.data, c.y.data, c.z.data, c.w.data - margin);
         }
-        else if(dt == DrawType::Lines)
+
+        if(all)
         {
-            out = in;
+            tally(&PipelineStats::culled, 1);
+            return Containment::Outside;
         }
-        else if(dt == DrawType::Line_Strip)
+        return any ? Containment::Intersecting : Containment::Inside;
+    }
+
+    //every primitive of N vertices accepted without looking at outcodes, for draws whose bounds are inside the view volume
+    template<uint8_t N, math::Scalar S>
+    void run_accept_function(BasicVertexStream<S> const & in, std::span<const uint32_t> const prims, BasicVertexStream<S>& out)
+    {
+        uint32_t const n = prims.size() - prims.size() % N;
+        out.resize(n);
+        for(uint32_t i = 0; i < n; ++i)
         {
-            for(uint8_t i = 0; i < in.size() - 1; ++i)
-            {
-                out.push_back( in[i] );
-                out.push_back( in[i + 1] );
-            }
+            out.copy(i, in, prims[i]);
         }
-        else if (dt == DrawType::Line_Loop)
+        tally(&PipelineStats::primitives, n / N);
+        tally(&PipelineStats::accepted, n / N);
+    }
+
+    //copies the points inside the view volume from in to out, a point is accepted or rejected whole
+    template<math::Scalar S>
+    void run_clip_points(BasicVertexStream<S> const & in, std::span<const uint32_t> const points, BasicVertexStream<S>& out)
+    {
+        out.resize(points.size());
+        uint32_t o = 0;
+        for(uint32_t const i : points)
         {
-            for(uint8_t i = 0; i < in.size() - 1; ++i)
+            if(in.clip[i] == 0)
             {
-                out.push_back( in[i] );
-                out.push_back( in[i + 1] );
+                out.copy(o++, in, i);
             }
-            out.push_back(in[in.size() - 1]);
-            out.push_back(in[0]);
         }
 
-        return out;
+        out.resize(o);
+        tally(&PipelineStats::primitives, points.size());
+        tally(&PipelineStats::accepted, o);
+        tally(&PipelineStats::rejected, points.size() - o);
     }
 
-
-    void vertex_pipeline()
+    //copies accepted and clipped segments from in to out, two endpoints per segment
+    template<math::Scalar S>
+    void run_clip_function(BasicVertexStream<S> const & in, std::span<const uint32_t> const segments, BasicVertexStream<S>& out)
     {
-        std::vector<Vertex> clip_buff = run_vertex_function(work_buff);
-        std::vector<Vertex> line_buff = convert_to_lines(clip_buff, draw_type);
-        std::vector<Vertex> ndc_buff = run_clip_function(line_buff);
-        std::vector<Vertex> wt_buff = run_ndc_function(ndc_buff);
-        std::vector<Vertex> draw_buff = run_windowtransform_function(wt_buff);
-        run_draw_function(draw_buff);
-    }
+        out.resize(segments.size());
+        uint32_t o = 0;
+        uint32_t accepted = 0;
+        uint32_t clipped = 0;
 
-    std::vector<Vertex> run_vertex_function(std::vector<Vertex>& in)
-    {
-        std::vector<Vertex> out;
-        for (auto& i : in)
+        for(uint32_t i = 0; i + 1 < segments.size(); i = i + 2)
         {
-            out.push_back(  Vertex{ vertex_function[0](i.pos) , i.col }  );
+            uint32_t const ia = segments[i];
+            uint32_t const ib = segments[i+1];
+            uint8_t const ca = in.clip[ia];
+            uint8_t const cb = in.clip[ib];
+
+            if((ca | cb) == 0)
+            {
+                //trivial accept
+                out.copy(o++, in, ia);
+                out.copy(o++, in, ib);
+                ++accepted;
+                continue;
+            }
+            if(ca & cb)
+            {
+                //trivial reject, both outside the same plane
+                continue;
+            }
+
+            BasicVertex<S> a = in.vertex(ia);
+            BasicVertex<S> b = in.vertex(ib);
+            if(clip_line(a, b))
+            {
+                out.setVertex(o++, a);
+                out.setVertex(o++, b);
+                ++clipped;
+            }
         }
-        return out;
+
+        out.resize(o);
+        tally(&PipelineStats::primitives, segments.size() / 2);
+        tally(&PipelineStats::accepted, accepted);
+        tally(&PipelineStats::clipped, clipped);
+        tally(&PipelineStats::rejected, segments.size() / 2 - accepted - clipped);
     }
-    std::vector<Vertex> run_clip_function(std::vector<Vertex>& in)
+
+    //copies accepted triangles from in to out, crossing triangles are clipped to a polygon and written as its fan
+    template<math::Scalar S>
+    void run_clip_triangles(BasicVertexStream<S> const & in, std::span<const uint32_t> const triangles, BasicVertexStream<S>& out)
     {
-        std::vector<Vertex> out;
+        out.resize(triangles.size());
+        uint32_t o = 0;
+        uint32_t accepted = 0;
+        uint32_t clipped = 0;
+        BasicVertex<S> poly[9];
+
+        //a clipped triangle can become up to 7, out grows past the input size then and keeps the capacity
+        auto const room = [&](uint32_t const need)
+        {
+            if(o + need > out.size())
+            {
+                out.resize(std::max(out.size() * 2, o + need));
+            }
+        };
 
-        for(uint8_t i = 0; i < in.size() - 1; i = i + 2)
+        for(uint32_t i = 0; i + 2 < triangles.size(); i = i + 3)
         {
-            Vertex pi1, pi2, po1, po2;
-            pi1 = in[i];
-            pi2 = in[i+1];
-            bool pi1in = clip_point(pi1);
-            bool pi2in = clip_point(pi2);
-            if(pi1in && pi2in)
+            uint8_t const ca = in.clip[triangles[i]];
+            uint8_t const cb = in.clip[triangles[i+1]];
+            uint8_t const cc = in.clip[triangles[i+2]];
+
+            if((ca | cb | cc) == 0)
             {
-                out.push_back(pi1);
-                out.push_back(pi2);
+                room(3);
+                out.copy(o++, in, triangles[i]);
+                out.copy(o++, in, triangles[i+1]);
+                out.copy(o++, in, triangles[i+2]);
+                ++accepted;
+                continue;
             }
-            else if(pi1in || pi2in)
+            if(ca & cb & cc)
             {
-                clip_line_component(pi1,pi2, 0, 1.0_fx, po1, po2);
-                clip_line_component(po1,po2, 0, -1.0_fx, pi1, pi2);
-                clip_line_component(pi1,pi2, 1, 1.0_fx, po1, po2);
-                clip_line_component(po1,po2, 1, -1.0_fx, pi1, pi2);
-                clip_line_component(pi1,pi2, 2, 1.0_fx, po1, po2);
-                clip_line_component(po1,po2, 2, -1.0_fx, pi1, pi2);
-
-                out.push_back( pi1 );
-                out.push_back( pi2 );
+                continue;
             }
 
+            for(uint8_t k = 0; k < 3; ++k)
+            {
+                poly[k] = in.vertex(triangles[i + k]);
+            }
+            uint8_t const n = clip_polygon(poly, ca | cb | cc);
+            if(n < 3)
+            {
+                continue;
+            }
 
+            room((n - 2) * 3);
+            for(uint8_t k = 1; k + 1 < n; ++k)
+            {
+                out.setVertex(o++, poly[0]);
+                out.setVertex(o++, poly[k]);
+                out.setVertex(o++, poly[k + 1]);
+            }
+            ++clipped;
         }
 
-        return  out;
+        out.resize(o);
+        tally(&PipelineStats::primitives, triangles.size() / 3);
+        tally(&PipelineStats::accepted, accepted);
+        tally(&PipelineStats::clipped, clipped);
+        tally(&PipelineStats::rejected, triangles.size() / 3 - accepted - clipped);
+    }
+
+    //drops triangles facing away from cull and those without area, in place on the window space stream
+    //the area is taken at the 28.4 subpixels TriangleSetup rasterizes, window y points down so front faces are negative
+    void run_cull_function(VertexStream& in, CullFace const cull)
+    {
+        uint32_t o = 0;
+        for(uint32_t i = 0; i + 2 < in.size(); i = i + 3)
+        {
+            int64_t const x0 = in.x[i] >> 12;
+            int64_t const y0 = in.y[i] >> 12;
+            int64_t const area = ((in.x[i+1] >> 12) - x0) * ((in.y[i+2] >> 12) - y0) -
+                                 ((in.y[i+1] >> 12) - y0) * ((in.x[i+2] >> 12) - x0);
+            if(area == 0 || (cull == CullFace::Back && area > 0) || (cull == CullFace::Front && area < 0))
+            {
+                continue;
+            }
+            if(o != i)
+            {
+                in.copy(o, in, i, 3);
+            }
+            o = o + 3;
+        }
+        tally(&PipelineStats::discarded, (in.size() - o) / 3);
+        in.resize(o);
     }
-    std::vector<Vertex> run_ndc_function(std::vector<Vertex>& in)
+
+    //perspective divide and window transform fused, with the viewport constants from setViewPort
+    template<math::Scalar S>
+    void run_ndc_function(BasicVertexStream<S>& in)
     {
-        std::vector<Vertex> out;
-        for (auto& i : in)
+        math::Viewport<S> vp;
+        for(uint8_t a = 0; a < 3; ++a)
         {
-            out.push_back( Vertex{ { i.pos / i.pos.w }, i.col });
+            vp.scale[a] = math::scalar_cast<S>(viewport.scale[a]);
+            vp.bias[a] = math::scalar_cast<S>(viewport.bias[a]);
         }
-        return out;
+        math::project(in.x.data(), in.y.data(), in.z.data(), in.w.data(), in.padded(), vp);
     }
-    std::vector<Vertex> run_windowtransform_function(std::vector<Vertex>& in)
+
+    //window space of the float and double pipelines to the 16.16 backends read
+    template<std::floating_point S>
+    void run_quantize_function(BasicVertexStream<S> const & in, VertexStream& out)
     {
-        std::vector<Vertex> out;
-        for (auto& i : in)
+        out.resize(in.size());
+        for(uint32_t i = 0; i < in.size(); ++i)
         {
-            out.push_back
-                (
-                    Vertex
-                    {
-                        {
-                     ((math::fixed32(xres) / 2.0_fx) * i.pos.x) + (static_cast<math::fixed32>(xres) / 2.0_fx),
-                            -((static_cast<math::fixed32>(yres) / 2.0_fx) * i.pos.y) + (static_cast<math::fixed32>(yres) / 2.0_fx),
-                            ((1.0_fx / 2.0_fx) * i.pos.z) + (1.0_fx / 2.0_fx),
-                            i.pos.w
-                        },
-                        i.col
-                    }
-                    );
+            out.x[i] = static_cast<int32_t>(in.x[i] * S(65536));
+            out.y[i] = static_cast<int32_t>(in.y[i] * S(65536));
+            out.z[i] = static_cast<int32_t>(in.z[i] * S(65536));
+            out.w[i] = 65536;
         }
-        return out;
+        std::copy_n(in.col.begin(), in.size(), out.col.begin());
+        std::copy_n(in.clip.begin(), in.size(), out.clip.begin());
     }
 
-    void run_draw_function(std::vector<Vertex>& in)
+    void run_point_function(VertexStream const & in, uint32_t const first, uint32_t const n)
     {
-        if(in.empty())
+        if(n == 0)
         {
             return;
         }
 
-        for(uint32_t i = 0; i < in.size() - 1; i = i + 2)
+        tally(&PipelineStats::points, n);
+        if(async)
         {
+            submit(RasterCommand::Kind::Points, in, first, n);
+            return;
+        }
+        points(in, first, n);
+    }
 
+    void run_draw_function(VertexStream const & in, uint32_t const first, uint32_t const n)
+    {
+        if(n == 0)
+        {
+            return;
+        }
 
-            //laserOff();
-            //laserMove(in[i].pos.x, in[i].pos.y);
-            //laserOn();
-            //laserColor(in[i].col.r, in[i].col.g, in[i].col.b);
-
-            line(static_cast<int16_t>(in[i].pos.x),
-                 static_cast<int16_t>(in[i].pos.y),
-                 static_cast<int16_t>(in[i+1].pos.x),
-                 static_cast<int16_t>(in[i+1].pos.y),
-                 in[i].col);
+        tally(&PipelineStats::segments, n / 2);
+        if(async)
+        {
+            submit(RasterCommand::Kind::Lines, in, first, n);
+            return;
+        }
+        lines(in, first, n);
+    }
 
+    void run_triangle_function(VertexStream const & in, uint32_t const first, uint32_t const n)
+    {
+        if(n == 0)
+        {
+            return;
+        }
 
-            //laserMove(in[i+1].pos.x, in[i+1].pos.y);
-            //laserColor(in[i+1].col.r, in[i+1].col.g, in[i].col.b);
+        tally(&PipelineStats::triangles, n / 3);
+        if(async)
+        {
+            submit(RasterCommand::Kind::Triangles, in, first, n);
+            return;
         }
-        //laserOff();
+        triangles(in, first, n);
     }
 
-    // returns true if point is inside volume
-    bool clip_point(const Vertex& in)
+    //window space primitives of a display list batch to the hook for their vertex count
+    void run_primitive_function(uint8_t const vertices, VertexStream const & in, uint32_t const first, uint32_t const n)
     {
-        if ((in.pos.x < -in.pos.w ||
-             in.pos.x > in.pos.w ||
-             in.pos.y < -in.pos.w ||
-             in.pos.y > in.pos.w ||
-             in.pos.z < -in.pos.w ||
-             in.pos.z > in.pos.w))
+        if(vertices == 3)
         {
-            return false;
+            run_triangle_function(in, first, n);
+        }
+        else if(vertices == 1)
+        {
+            run_point_function(in, first, n);
         }
         else
         {
-            return true;
+            run_draw_function(in, first, n);
         }
     }
 
-    void clip_line_component(const Vertex& q1, const Vertex& q2,
-                             const uint8_t index, const math::fixed32 factor,
-                             Vertex& q1new, Vertex& q2new)
+    //queues a draw for the raster thread, the stream is copied into the ring slot
+    void submit(RasterCommand::Kind const kind, VertexStream const & in, uint32_t const first, uint32_t const n)
     {
-        q1new = q1;
-        q2new = q2;
-
-        Vertex previousVertex = q2;
-        math::fixed32 previousComponent = previousVertex.pos[index] * factor;
-        bool previousInside = previousComponent <= previousVertex.pos.w;
-
-        Vertex currentVertex = q1;
-        math::fixed32 currentComponent = currentVertex.pos[index] * factor;
-        bool currentInside = currentComponent <= currentVertex.pos.w;
+        RasterCommand& c = async->ring.back();
+        c.kind = kind;
+        c.stream.resize(n);
+        c.stream.copy(0, in, first, n);
+        async->ring.push();
+    }
 
-        if((currentInside) && (!previousInside))
+    void submit(RasterCommand::Kind const kind)
+    {
+        if(async)
         {
-            math::fixed32 lerpAmount = (previousVertex.pos.w - previousComponent) /
-                               ((previousVertex.pos.w - previousComponent) -
-                                (currentVertex.pos.w - currentComponent));
-            q2new.pos = fren::math::mix(previousVertex.pos, currentVertex.pos, lerpAmount);
-
-            //fren::math::vec3 p2v3 = fren::math::mix(fren::math::vec3(previousVertex.pos), fren::math::vec3(currentVertex.pos), lerpAmount);
-            //q2new.pos = fren::math::vec4(p2v3, previousVertex.pos.w);
-
+            async->ring.back().kind = kind;
+            async->ring.push();
             return;
+        }
+        execute(kind);
+    }
 
+    void execute(RasterCommand::Kind const kind)
+    {
+        if(kind == RasterCommand::Kind::Clear)
+        {
+            clear();
         }
-        else if((!currentInside) && (previousInside))
+        else if(kind == RasterCommand::Kind::Present)
         {
-            math::fixed32 lerpAmount = (currentVertex.pos.w - currentComponent) /
-                               ((currentVertex.pos.w - currentComponent) -
-                                (previousVertex.pos.w - previousComponent));
-            q1new.pos = fren::math::mix(currentVertex.pos, previousVertex.pos, lerpAmount);
-            return;
+            present();
         }
-        return;
     }
 
+    void raster_loop()
+    {
+        while(true)
+        {
+            RasterCommand& c = async->ring.front();
+            switch(c.kind)
+            {
+            case RasterCommand::Kind::Points:
+                points(c.stream, 0, c.stream.size());
+                break;
+            case RasterCommand::Kind::Lines:
+                lines(c.stream, 0, c.stream.size());
+                break;
+            case RasterCommand::Kind::Triangles:
+                triangles(c.stream, 0, c.stream.size());
+                break;
+            case RasterCommand::Kind::DepthTest:
+                depth_test = c.enable;
+                break;
+            case RasterCommand::Kind::Fence:
+                async->completed.store(c.fence, std::memory_order_release);
+                async->completed.notify_all();
+                break;
+            case RasterCommand::Kind::Quit:
+                async->ring.pop();
+                return;
+            default:
+                execute(c.kind);
+                break;
+            }
+            async->ring.pop();
+        }
+    }
 
-};
-
-
-
-
-
-
-    /*
-def Render(p, phi, height, horizon, scale_height, distance, screen_width, screen_height):
-    # precalculate viewing angle parameters
-    var sinphi = math.sin(phi);
-    var cosphi = math.cos(phi);
-
-    # initialize visibility array. Y position for each column on screen
-    ybuffer = np.zeros(screen_width)
-    for i in range(0, screen_width):
-        ybuffer[i] = screen_height
+    //signed distance to a clip plane, >= 0 is inside
+    template<math::Scalar S>
+    static auto plane_distance(const math::basic_vec4<S>& p, uint8_t const plane) -> S
+    {
+        switch(plane)
+        {
+        case 0: return p.w - p.x;
+        case 1: return p.w + p.x;
+        case 2: return p.w - p.y;
+        case 3: return p.w + p.y;
+        case 4: return p.w - p.z;
+        default: return p.w + p.z;
+        }
+    }
 
-    # Draw from front to the back (low z coordinate to high z coordinate)
-    dz = 1.
-    z = 1.
-    while z < distance
-        # Find line on map. This calculation corresponds to a field of view of 90°
-        pleft = Point(
-            (-cosphi*z - sinphi*z) + p.x,
-            ( sinphi*z - cosphi*z) + p.y)
-        pright = Point(
-            ( cosphi*z - sinphi*z) + p.x,
-            (-sinphi*z - cosphi*z) + p.y)
+    //where a segment crosses a plane, as the fraction of the way from a to b
+    //da and db straddle the plane, so |da| <= |da - db| and the fixed32 reciprocal is within 1 lsb
+    template<math::Scalar S>
+    static auto crossing(S const da, S const db) -> S
+    {
+        if constexpr (std::is_same_v<S, math::fixed32>)
+        {
+            return math::reciprocal(da - db)(da);
+        }
+        else
+        {
+            return da / (da - db);
+        }
+    }
 
-        # segment the line
-        dx = (pright.x - pleft.x) / screen_width
-        dy = (pright.y - pleft.y) / screen_width
+    //sutherland-hodgman in homogeneous clip space against the planes in the outcodes, poly holds 3 vertices and room for 9
+    //returns the vertex count left, below 3 when the triangle misses the volume, every vertex keeps the first color
+    //crossings are always taken from the inside vertex so an edge shared by two triangles clips to the same point
+    template<math::Scalar S>
+    static auto clip_polygon(BasicVertex<S>* poly, uint8_t const planes) -> uint8_t
+    {
+        BasicVertex<S> tmp[9];
+        uint8_t n = 3;
+        uint16_t const color = poly[0].col;
+        S const zero = S(0.0f);
+        for(uint8_t p = 0; p < 6 && n >= 3; ++p)
+        {
+            if(!(planes & (1 << p)))
+            {
+                continue;
+            }
 
-        # Raster line and draw a vertical line for each segment
-        for i in range(0, screen_width):
-            height_on_screen = (height - heightmap[pleft.x, pleft.y]) / z * scale_height. + horizon
-            DrawVerticalLine(i, height_on_screen, ybuffer[i], colormap[pleft.x, pleft.y])
-            if height_on_screen < ybuffer[i]:
-                ybuffer[i] = height_on_screen
-            pleft.x += dx
-            pleft.y += dy
+            uint8_t m = 0;
+            for(uint8_t k = 0; k < n; ++k)
+            {
+                BasicVertex<S> const & a = poly[k];
+                BasicVertex<S> const & b = poly[k + 1 == n ? 0 : k + 1];
+                S const da = plane_distance(a.pos, p);
+                S const db = plane_distance(b.pos, p);
+                if(da >= zero)
+                {
+                    tmp[m++] = {a.pos, color};
+                }
+                if(da >= zero && db < zero)
+                {
+                    tmp[m++] = {fren::math::mix(a.pos, b.pos, crossing(da, db)), color};
+                }
+                else if(da < zero && db >= zero)
+                {
+                    tmp[m++] = {fren::math::mix(b.pos, a.pos, crossing(db, da)), color};
+                }
+            }
+            std::copy_n(tmp, m, poly);
+            n = m;
+        }
+        return n;
+    }
 
-        # Go to next line and increase step size when you are far away
-        z += dz
-        dz += 0.2
+    //liang-barsky in homogeneous clip space, only the planes in the outcodes are tested
+    //returns false when the segment misses the volume, keeps the color of the first vertex
+    template<math::Scalar S>
+    bool clip_line(BasicVertex<S>& a, BasicVertex<S>& b)
+    {
+        uint8_t const planes = a.clip | b.clip;
+        S const zero = S(0.0f);
+        S const one = S(1.0f);
+        S t0 = zero;
+        S t1 = one;
 
-# Call the render function with the camera parameters:
-# position, viewing angle, height, horizon line position,
-# scaling factor for the height, the largest distance,
-# screen width and the screen height parameter
-Render( Point(0, 0), 0, 50, 120, 120, 300, 800, 600 )
+        for(uint8_t p = 0; p < 6; ++p)
+        {
+            if(!(planes & (1 << p)))
+            {
+                continue;
+            }
 
-void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
-{
-    int16_t dx = std::abs(x1 - x0);
-    int16_t dy = std::abs(y1 - y0);
-    int16_t sx = (x0 < x1) ? 1 : -1;
-    int16_t sy = (y0 < y1) ? 1 : -1;
-    int16_t err = dx - dy;
+            S const da = plane_distance(a.pos, p);
+            S const db = plane_distance(b.pos, p);
 
-    while (true)
-    {
-        plot(x0, y0);
+            if(da < zero)
+            {
+                if(db < zero)
+                {
+                    return false;
+                }
+                S const t = crossing(da, db);
+                t0 = t > t0 ? t : t0;
+            }
+            else if(db < zero)
+            {
+                S const t = crossing(da, db);
+                t1 = t < t1 ? t : t1;
+            }
 
-        if (x0 == x1 && y0 == y1)
-        {
-            break;
+            if(t0 > t1)
+            {
+                return false;
+            }
         }
 
-        int16_t e2 = 2 * err;
-
-        if (e2 > -dy)
+        math::basic_vec4<S> const pa = a.pos;
+        if(t0 > zero)
         {
-            err -= dy;
-            x0 += sx;
+            a.pos = fren::math::mix(pa, b.pos, t0);
         }
-
-        if (e2 < dx)
+        if(t1 < one)
         {
-            err += dx;
-            y0 += sy;
+            b.pos = fren::math::mix(pa, b.pos, t1);
         }
+        return true;
     }
-}
 
-
-
-
-*/
+};
 
 }
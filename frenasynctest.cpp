@@ -0,0 +1,108 @@
+#include "frenfb.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//frames drawn with setAsync(true) against the same frames drawn synchronously, compared by a hash of every presented frame
+//depth testing toggles within frames, display lists replay, and the vertex data changes after each frame is submitted
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec3;
+
+constexpr uint32_t frames = 40;
+
+int failures = 0;
+
+//fnv-1a over the pixels at every present(), which runs on the raster thread in async mode
+class Hashing : public fren::FramebufferContext
+{
+public:
+    std::vector<uint64_t> hashes;
+
+    ~Hashing() override
+    {
+        setAsync(false);
+    }
+
+    void present() override
+    {
+        uint64_t h = 1469598103934665603ull;
+        for(uint16_t y = 0; y < yres; ++y)
+        {
+            for(uint16_t x = 0; x < xres; ++x)
+            {
+                h = (h ^ pixel(x, y)) * 1099511628211ull;
+            }
+        }
+        hashes.push_back(h);
+    }
+};
+
+auto run(bool const async, uint32_t const threads) -> std::vector<uint64_t>
+{
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> u(-1.2f, 1.2f);
+    std::vector<vec3> verts(3000);
+    std::vector<uint16_t> colors(verts.size());
+    for(std::size_t i = 0; i < verts.size(); ++i)
+    {
+        verts[i] = {{fixed32(u(rng)), fixed32(u(rng))}, fixed32(u(rng))};
+        colors[i] = static_cast<uint16_t>(rng() & 0x7FFF);
+    }
+
+    Hashing ctx;
+    fren::MatrixVertexFunction identity;
+    ctx.setViewPort(320, 240);
+    ctx.setRasterThreads(threads);
+    ctx.setVertexFunction(&identity);
+    ctx.setAsync(async);
+    ctx.VertexPointer(3, verts.data());
+    ctx.ColorPointer(colors.data());
+
+    fren::DisplayList list;
+    ctx.NewList(list);
+    ctx.DrawArray(fren::DrawType::Line_Strip, 0, 500);
+    ctx.DrawArray(fren::DrawType::Points, 500, 300);
+    ctx.EndList();
+
+    for(uint32_t f = 0; f < frames; ++f)
+    {
+        ctx.Clear();
+        ctx.setDepthTest(f % 2 == 1);
+        ctx.DrawArray(fren::DrawType::Lines, (f * 37) % 1000, 2000);
+        ctx.DrawArray(fren::DrawType::Triangles, 0, 300);
+        ctx.CallList(list);
+        ctx.setDepthTest(f % 3 == 0);
+        ctx.DrawArray(fren::DrawType::Points, 100, 1200);
+        ctx.DrawArray(fren::DrawType::Line_Loop, 2000, 200);
+        ctx.Present();
+
+        //the submitted frame holds its own window space copy, the next one sees the moved vertices
+        for(std::size_t i = f % 7; i < verts.size(); i += 7)
+        {
+            verts[i].x = -verts[i].x;
+        }
+    }
+    ctx.Finish();
+    return ctx.hashes;
+}
+
+}
+
+auto main() -> int
+{
+    std::vector<uint64_t> const reference = run(false, 1);
+    for(uint32_t const threads : {1u, 4u})
+    {
+        std::vector<uint64_t> const hashes = run(true, threads);
+        bool const ok = reference.size() == frames && hashes == reference;
+        std::printf("async, %u raster threads, %zu frames %s\n", threads, hashes.size(), ok ? "ok" : "FAILED");
+        failures += ok ? 0 : 1;
+    }
+    return failures ? 1 : 0;
+}
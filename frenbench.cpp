@@ -0,0 +1,845 @@
+#include "frenfb.hpp"
+#include "frenvoxel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+//counts heap allocations so the report can show what a steady state frame allocates
+static uint64_t alloc_count = 0;
+
+void* operator new(std::size_t n)
+{
+    ++alloc_count;
+    if(void* p = std::malloc(n ? n : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, std::align_val_t a)
+{
+    ++alloc_count;
+    std::size_t const align = static_cast<std::size_t>(a);
+    if(void* p = std::aligned_alloc(align, (n + align - 1) / align * align))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+//the replacements above allocate with malloc and aligned_alloc, so free is the matching release,
+//gcc only sees free paired with a new expression and warns
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+using fren::math::vec3;
+using fren::math::vec4;
+using fren::math::mat4;
+
+//segments and the other pipeline counters come from FREN_PIPELINE_STATS
+using BenchContext = fren::FramebufferContext;
+
+using MatrixShader = fren::MatrixVertexFunction;
+
+using DrawTypes = std::span<const std::pair<fren::DrawType, char const*>>;
+
+constexpr std::pair<fren::DrawType, char const*> draw_types[] =
+{
+    {fren::DrawType::Points, "points"},
+    {fren::DrawType::Lines, "lines"},
+    {fren::DrawType::Line_Strip, "line_strip"},
+    {fren::DrawType::Line_Loop, "line_loop"},
+};
+
+constexpr std::pair<fren::DrawType, char const*> fill_types[] =
+{
+    {fren::DrawType::Triangles, "triangles"},
+    {fren::DrawType::Triangle_Strip, "triangle_strip"},
+    {fren::DrawType::Triangle_Fan, "triangle_fan"},
+};
+
+//scenes that draw without the primitive pipeline, the draw type is ignored
+constexpr std::pair<fren::DrawType, char const*> column_types[] =
+{
+    {fren::DrawType::Points, "columns"},
+};
+
+struct Scene
+{
+    std::string name;
+    uint32_t vertices;
+    //issues one frame worth of draws
+    std::function<void(BenchContext&, MatrixShader&, fren::DrawType, uint32_t frame)> frame;
+    DrawTypes types = draw_types;
+};
+
+struct Result
+{
+    std::string name;
+    uint64_t vertices = 0;
+    uint64_t segments = 0;
+    double ns_per_frame = 0;
+    double allocs_per_frame = 0;
+    fren::Context::StageTimes stage_ns{};
+    fren::PipelineStats stats;
+};
+
+constexpr char const* stage_names[] = {"gather", "vertex", "lines", "clip", "ndc", "viewport", "draw"};
+static_assert(std::size(stage_names) == static_cast<std::size_t>(fren::PipelineStage::Count));
+
+constexpr std::pair<uint64_t fren::PipelineStats::*, char const*> stat_names[] =
+{
+    {&fren::PipelineStats::draws, "draws"},
+    {&fren::PipelineStats::culled, "culled"},
+    {&fren::PipelineStats::vertices, "vertices"},
+    {&fren::PipelineStats::shaded, "shaded"},
+    {&fren::PipelineStats::primitives, "primitives"},
+    {&fren::PipelineStats::deduplicated, "deduplicated"},
+    {&fren::PipelineStats::merged, "merged"},
+    {&fren::PipelineStats::accepted, "accepted"},
+    {&fren::PipelineStats::clipped, "clipped"},
+    {&fren::PipelineStats::rejected, "rejected"},
+    {&fren::PipelineStats::discarded, "discarded"},
+    {&fren::PipelineStats::points, "points"},
+    {&fren::PipelineStats::segments, "segments"},
+    {&fren::PipelineStats::triangles, "triangles"},
+    {&fren::PipelineStats::pixels, "pixels"},
+    {&fren::PipelineStats::occluded, "occluded"},
+};
+
+constexpr std::pair<fren::Precision, char const*> precisions[] =
+{
+    {fren::Precision::Fixed, "fixed"},
+    {fren::Precision::Float, "float"},
+    {fren::Precision::Double, "double"},
+};
+
+auto findPrecision(std::string const& name) -> std::size_t
+{
+    std::size_t p = 0;
+    while(p < std::size(precisions) && name != precisions[p].second)
+    {
+        ++p;
+    }
+    return p;
+}
+
+auto fx(float const f) -> fixed32
+{
+    return fixed32(f);
+}
+
+//random segments spread past the view volume so the clipper has work
+auto makeSoup(uint32_t const count) -> std::vector<vec2>
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> d(-1.5f, 1.5f);
+    std::vector<vec2> v(count);
+    for(auto& p : v)
+    {
+        p = vec2{fx(d(rng)), fx(d(rng))};
+    }
+    return v;
+}
+
+auto makeCircle(uint32_t const count, float const radius) -> std::vector<vec2>
+{
+    std::vector<vec2> v(count);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        float const a = 6.2831853f * float(i) / float(count);
+        float const r = radius * (0.5f + 0.5f * float(i % 97) / 97.0f);
+        v[i] = vec2{fx(r * std::cos(a)), fx(r * std::sin(a))};
+    }
+    return v;
+}
+
+const vec3 cube_vertices[8] =
+{
+    {{fx(-0.5f), fx(-0.5f)}, fx(-0.5f)}, {{fx(0.5f), fx(-0.5f)}, fx(-0.5f)},
+    {{fx(0.5f), fx(0.5f)}, fx(-0.5f)},   {{fx(-0.5f), fx(0.5f)}, fx(-0.5f)},
+    {{fx(-0.5f), fx(-0.5f)}, fx(0.5f)},  {{fx(0.5f), fx(-0.5f)}, fx(0.5f)},
+    {{fx(0.5f), fx(0.5f)}, fx(0.5f)},    {{fx(-0.5f), fx(0.5f)}, fx(0.5f)},
+};
+
+uint8_t cube_edges[24] =
+{
+    0,1, 1,2, 2,3, 3,0,
+    4,5, 5,6, 6,7, 7,4,
+    0,4, 1,5, 2,6, 3,7,
+};
+
+auto makeScenes() -> std::vector<Scene>
+{
+    std::vector<Scene> scenes;
+
+    //random line soup
+    {
+        auto soup = std::make_shared<std::vector<vec2>>(makeSoup(20000));
+        auto soup_small = std::make_shared<std::vector<vec2>>(makeSoup(256));
+        auto soup_index = std::make_shared<std::vector<uint8_t>>(20000);
+        std::mt19937 rng(99);
+        for(auto& i : *soup_index)
+        {
+            i = static_cast<uint8_t>(rng());
+        }
+
+        scenes.push_back({"soup/array", 20000, [soup](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, soup->data());
+            c.DrawArray(dt, 0, soup->size());
+        }});
+        //the same soup as an interleaved float struct with its color, converted while gathering
+        struct SoupVertex
+        {
+            float x, y;
+            uint16_t col;
+        };
+        auto soup_interleaved = std::make_shared<std::vector<SoupVertex>>();
+        for(vec2 const& p : *soup)
+        {
+            soup_interleaved->push_back({float(p.x.data) / 65536.0f, float(p.y.data) / 65536.0f, UINT16_MAX});
+        }
+        scenes.push_back({"soup/interleaved", 20000, [soup_interleaved](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, fren::ComponentType::Float, sizeof(SoupVertex), soup_interleaved->data());
+            c.ColorPointer(&soup_interleaved->front().col, sizeof(SoupVertex));
+            c.DrawArray(dt, 0, soup_interleaved->size());
+        }});
+        scenes.push_back({"soup/elements", 20000, [soup_small, soup_index](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, soup_small->data());
+            c.IndexPointer(soup_index->data());
+            c.DrawElements(dt, soup_index->size());
+        }});
+    }
+
+    //16x16 grid of rotating perspective cubes, one small draw per cube
+    {
+        auto cube_array = std::make_shared<std::vector<vec3>>();
+        for(uint8_t i : cube_edges)
+        {
+            cube_array->push_back(cube_vertices[i]);
+        }
+
+        auto cube_mvp = [](MatrixShader& s, uint32_t const frame, int const gx, int const gy)
+        {
+            mat4 const pj = fren::math::perspective(fx(1.0f), fx(1.5f), fx(0.5f), fx(100.0f));
+            fixed32 const angle = fx(0.02f * float(frame % 300) + 0.1f * float(gx + gy));
+            vec3 const pos{{fx(1.5f * float(gx - 8)), fx(1.5f * float(gy - 8))}, fx(-20.0f)};
+            vec3 const axis{{fx(0.577f), fx(0.577f)}, fx(0.577f)};
+            s.mvp = pj * fren::math::translate(pos) * fren::math::rotate(angle, axis);
+        };
+
+        scenes.push_back({"cubes/array", 16 * 16 * 24, [cube_array, cube_mvp](BenchContext& c, MatrixShader& s, fren::DrawType dt, uint32_t frame)
+        {
+            c.VertexPointer(3, cube_array->data());
+            for(int gy = 0; gy < 16; ++gy)
+            {
+                for(int gx = 0; gx < 16; ++gx)
+                {
+                    cube_mvp(s, frame, gx, gy);
+                    c.DrawArray(dt, 0, cube_array->size());
+                }
+            }
+        }});
+        scenes.push_back({"cubes/elements", 16 * 16 * 24, [cube_mvp](BenchContext& c, MatrixShader& s, fren::DrawType dt, uint32_t frame)
+        {
+            c.VertexPointer(3, const_cast<vec3*>(cube_vertices));
+            c.IndexPointer(cube_edges);
+            for(int gy = 0; gy < 16; ++gy)
+            {
+                for(int gx = 0; gx < 16; ++gx)
+                {
+                    cube_mvp(s, frame, gx, gy);
+                    c.DrawElements(dt, std::size(cube_edges));
+                }
+            }
+        }});
+        //same draws recorded once on the first frame, the cubes stay where frame 0 put them
+        auto cube_list = std::make_shared<fren::DisplayList>();
+        scenes.push_back({"cubes/list", 16 * 16 * 24, [cube_mvp, cube_list](BenchContext& c, MatrixShader& s, fren::DrawType dt, uint32_t frame)
+        {
+            if(frame == 0)
+            {
+                c.VertexPointer(3, const_cast<vec3*>(cube_vertices));
+                c.IndexPointer(cube_edges);
+                c.NewList(*cube_list);
+                for(int gy = 0; gy < 16; ++gy)
+                {
+                    for(int gx = 0; gx < 16; ++gx)
+                    {
+                        cube_mvp(s, frame, gx, gy);
+                        c.DrawElements(dt, std::size(cube_edges));
+                    }
+                }
+                c.EndList();
+            }
+            c.CallList(*cube_list);
+        }});
+    }
+
+    //64x64 field of the same cubes, only the middle of it is on screen
+    //with bounds the off screen cubes are skipped before gather and the inner ones skip clipping
+    {
+        auto field_mvp = [](MatrixShader& s, uint32_t const frame, int const gx, int const gy)
+        {
+            mat4 const pj = fren::math::perspective(fx(1.0f), fx(1.5f), fx(0.5f), fx(100.0f));
+            fixed32 const angle = fx(0.02f * float(frame % 300) + 0.1f * float(gx + gy));
+            vec3 const pos{{fx(1.5f * float(gx - 32)), fx(1.5f * float(gy - 32))}, fx(-20.0f)};
+            vec3 const axis{{fx(0.577f), fx(0.577f)}, fx(0.577f)};
+            s.mvp = pj * fren::math::translate(pos) * fren::math::rotate(angle, axis);
+        };
+
+        fren::Bounds const cube_bounds = fren::Bounds::of(std::span<const vec3>(cube_vertices));
+        for(bool const bounded : {false, true})
+        {
+            scenes.push_back({bounded ? "field/bounds" : "field/elements", 64 * 64 * 24, [field_mvp, cube_bounds, bounded](BenchContext& c, MatrixShader& s, fren::DrawType dt, uint32_t frame)
+            {
+                c.VertexPointer(3, const_cast<vec3*>(cube_vertices));
+                c.IndexPointer(cube_edges);
+                if(bounded)
+                {
+                    c.setBounds(cube_bounds);
+                }
+                for(int gy = 0; gy < 64; ++gy)
+                {
+                    for(int gx = 0; gx < 64; ++gx)
+                    {
+                        field_mvp(s, frame, gx, gy);
+                        c.DrawElements(dt, std::size(cube_edges));
+                    }
+                }
+            }});
+        }
+    }
+
+    //100k segment loops
+    {
+        auto loop = std::make_shared<std::vector<vec2>>(makeCircle(100000, 0.9f));
+        auto ring = std::make_shared<std::vector<vec2>>(makeCircle(256, 0.9f));
+        auto ring_index = std::make_shared<std::vector<uint8_t>>(100000);
+        for(uint32_t i = 0; i < ring_index->size(); ++i)
+        {
+            (*ring_index)[i] = static_cast<uint8_t>(i);
+        }
+
+        scenes.push_back({"loop100k/array", 100000, [loop](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, loop->data());
+            c.DrawArray(dt, 0, loop->size());
+        }});
+        scenes.push_back({"loop100k/elements", 100000, [ring, ring_index](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, ring->data());
+            c.IndexPointer(ring_index->data());
+            c.DrawElements(dt, ring_index->size());
+        }});
+    }
+
+    //256x256 vertex wireframe grid with 32 bit indices, every vertex is shared by up to four edges
+    {
+        constexpr uint32_t side = 256;
+        auto grid = std::make_shared<std::vector<vec2>>(side * side);
+        auto grid_index = std::make_shared<std::vector<uint32_t>>();
+        for(uint32_t y = 0; y < side; ++y)
+        {
+            for(uint32_t x = 0; x < side; ++x)
+            {
+                (*grid)[y * side + x] = vec2{fx(2.4f * float(x) / float(side - 1) - 1.2f),
+                                             fx(2.4f * float(y) / float(side - 1) - 1.2f)};
+                if(x + 1 < side)
+                {
+                    grid_index->push_back(y * side + x);
+                    grid_index->push_back(y * side + x + 1);
+                }
+                if(y + 1 < side)
+                {
+                    grid_index->push_back(y * side + x);
+                    grid_index->push_back((y + 1) * side + x);
+                }
+            }
+        }
+        auto grid_array = std::make_shared<std::vector<vec2>>();
+        for(uint32_t i : *grid_index)
+        {
+            grid_array->push_back((*grid)[i]);
+        }
+
+        uint32_t const count = grid_index->size();
+        scenes.push_back({"grid/array", count, [grid_array](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, grid_array->data());
+            c.DrawArray(dt, 0, grid_array->size());
+        }});
+        scenes.push_back({"grid/elements", count, [grid, grid_index](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            c.VertexPointer(2, grid->data());
+            c.IndexPointer(grid_index->data());
+            c.DrawElements(dt, grid_index->size());
+        }});
+        auto grid_list = std::make_shared<fren::DisplayList>();
+        scenes.push_back({"grid/list", count, [grid, grid_index, grid_list](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t frame)
+        {
+            if(frame == 0)
+            {
+                c.VertexPointer(2, grid->data());
+                c.IndexPointer(grid_index->data());
+                c.NewList(*grid_list);
+                c.DrawElements(dt, grid_index->size());
+                c.EndList();
+            }
+            c.CallList(*grid_list);
+        }});
+    }
+
+    //hud, 48 panels in a grid behind 4 large overlapping occluders, one quad per draw
+    //the quad is laid out for the draw type, 6 vertices for triangles, 4 in strip or fan order otherwise
+    {
+        auto quad = [](float const x0, float const y0, float const x1, float const y1, fren::DrawType const dt)
+        {
+            vec2 const a{fx(x0), fx(y0)}, b{fx(x1), fx(y0)}, c{fx(x1), fx(y1)}, d{fx(x0), fx(y1)};
+            if(dt == fren::DrawType::Triangles)
+            {
+                return std::vector<vec2>{a, b, c, a, c, d};
+            }
+            if(dt == fren::DrawType::Triangle_Strip)
+            {
+                return std::vector<vec2>{a, b, d, c};
+            }
+            return std::vector<vec2>{a, b, c, d};
+        };
+
+        auto panels = std::make_shared<std::map<fren::DrawType, std::vector<vec2>>>();
+        auto colors = std::make_shared<std::vector<uint16_t>>();
+        for(auto const& [dt, name] : fill_types)
+        {
+            std::vector<vec2>& v = (*panels)[dt];
+            for(int py = 0; py < 6; ++py)
+            {
+                for(int px = 0; px < 8; ++px)
+                {
+                    std::vector<vec2> const q = quad(-0.95f + 0.24f * px, -0.95f + 0.32f * py,
+                                                     -0.95f + 0.24f * px + 0.2f, -0.95f + 0.32f * py + 0.26f, dt);
+                    v.insert(v.end(), q.begin(), q.end());
+                }
+            }
+            for(int o = 0; o < 4; ++o)
+            {
+                std::vector<vec2> const q = quad(-0.8f + 0.3f * o, -0.6f + 0.2f * o, 0.1f + 0.3f * o, 0.3f + 0.2f * o, dt);
+                v.insert(v.end(), q.begin(), q.end());
+            }
+        }
+        for(uint32_t i = 0; i < (*panels)[fren::DrawType::Triangles].size(); ++i)
+        {
+            colors->push_back(fren::Convert888to555(uint8_t(i * 37), uint8_t(i * 91), uint8_t(i * 13)));
+        }
+
+        scenes.push_back({"hud/array", 52 * 6, [panels, colors](BenchContext& c, MatrixShader&, fren::DrawType dt, uint32_t)
+        {
+            std::vector<vec2> const& v = panels->at(dt);
+            uint32_t const per_quad = v.size() / 52;
+            c.VertexPointer(2, const_cast<vec2*>(v.data()));
+            c.ColorPointer(colors->data());
+            for(uint32_t q = 0; q < 52; ++q)
+            {
+                c.DrawArray(dt, q * per_quad, per_quad);
+            }
+        }, fill_types});
+    }
+
+    //rotating perspective sphere of 64x32 quads as indexed triangles, half of it back facing
+    {
+        constexpr uint32_t slices = 64;
+        constexpr uint32_t stacks = 32;
+        auto sphere = std::make_shared<std::vector<vec3>>();
+        auto sphere_colors = std::make_shared<std::vector<uint16_t>>();
+        for(uint32_t st = 0; st <= stacks; ++st)
+        {
+            for(uint32_t sl = 0; sl <= slices; ++sl)
+            {
+                float const theta = 3.1415927f * float(st) / stacks;
+                float const phi = 6.2831853f * float(sl) / slices;
+                sphere->push_back({{fx(std::sin(theta) * std::cos(phi)), fx(std::cos(theta))}, fx(std::sin(theta) * std::sin(phi))});
+                sphere_colors->push_back(fren::Convert888to555(uint8_t(st * 8), uint8_t(sl * 4), 160));
+            }
+        }
+        //the first triangle of every quad gets a distinct vertex so the colors form a checker
+        auto sphere_index = std::make_shared<std::vector<uint16_t>>();
+        for(uint32_t st = 0; st < stacks; ++st)
+        {
+            for(uint32_t sl = 0; sl < slices; ++sl)
+            {
+                uint16_t const a = st * (slices + 1) + sl;
+                uint16_t const b = a + slices + 1;
+                for(uint16_t const i : {a, uint16_t(a + 1), b, uint16_t(b + 1), b, uint16_t(a + 1)})
+                {
+                    sphere_index->push_back(i);
+                }
+            }
+        }
+
+        scenes.push_back({"sphere/elements", stacks * slices * 6, [sphere, sphere_colors, sphere_index](BenchContext& c, MatrixShader& s, fren::DrawType dt, uint32_t frame)
+        {
+            mat4 const pj = fren::math::perspective(fx(1.0f), fx(1.33f), fx(0.5f), fx(100.0f));
+            fixed32 const angle = fx(0.02f * float(frame % 300));
+            vec3 const axis{{fx(0.0f), fx(1.0f)}, fx(0.0f)};
+            s.mvp = pj * fren::math::translate({{fx(0.0f), fx(0.0f)}, fx(-2.6f)}) * fren::math::rotate(angle, axis);
+            c.setCullFace(fren::CullFace::Back);
+            c.VertexPointer(3, sphere->data());
+            c.ColorPointer(sphere_colors->data());
+            c.IndexPointer(sphere_index->data());
+            c.DrawElements(dt, sphere_index->size());
+        }, std::span(fill_types).first(1)});
+
+        //the same sphere as a depth tested wireframe, each triangle of the index list drawn as three segments
+        scenes.push_back({"sphere/depth", stacks * slices * 6, [sphere, sphere_colors, sphere_index](BenchContext& c, MatrixShader& s, fren::DrawType dt, uint32_t frame)
+        {
+            mat4 const pj = fren::math::perspective(fx(1.0f), fx(1.33f), fx(0.5f), fx(100.0f));
+            fixed32 const angle = fx(0.02f * float(frame % 300));
+            vec3 const axis{{fx(0.0f), fx(1.0f)}, fx(0.0f)};
+            s.mvp = pj * fren::math::translate({{fx(0.0f), fx(0.0f)}, fx(-2.6f)}) * fren::math::rotate(angle, axis);
+            c.setDepthTest(true);
+            c.VertexPointer(3, sphere->data());
+            c.ColorPointer(sphere_colors->data());
+            c.IndexPointer(sphere_index->data());
+            c.DrawElements(dt, sphere_index->size());
+        }, std::span(draw_types).subspan(1, 1)});
+    }
+
+    //voxel terrain flyover over a 1024x1024 map of summed sines, at a handheld and a desktop resolution
+    {
+        constexpr uint8_t size_log2 = 10;
+        constexpr uint32_t size = 1 << size_log2;
+        auto heights = std::make_shared<std::vector<uint8_t>>(size * size);
+        auto colors = std::make_shared<std::vector<uint16_t>>(size * size);
+        uint8_t max_height = 0;
+        for(uint32_t y = 0; y < size; ++y)
+        {
+            for(uint32_t x = 0; x < size; ++x)
+            {
+                //periods divide the map size so it wraps without seams
+                float const u = 6.2831853f * float(x) / size;
+                float const v = 6.2831853f * float(y) / size;
+                float const h = 90.0f + 50.0f * std::sin(3 * u) * std::cos(2 * v) + 30.0f * std::sin(7 * u + 5 * v) + 12.0f * std::cos(23 * u - 17 * v);
+                uint8_t const height = uint8_t(std::clamp(h, 0.0f, 255.0f));
+                (*heights)[y * size + x] = height;
+                (*colors)[y * size + x] = height < 60 ? fren::Convert888to555(40, 80, 200)
+                                        : height < 150 ? fren::Convert888to555(uint8_t(height / 2), uint8_t(height), 40)
+                                        : fren::Convert888to555(height, height, height);
+                max_height = std::max(max_height, height);
+            }
+        }
+        fren::Heightmap const map{heights->data(), colors->data(), size_log2, max_height};
+        auto terrain = std::make_shared<fren::TerrainRenderer>();
+
+        for(auto const& [w, h, name] : {std::tuple<uint16_t, uint16_t, char const*>{240, 160, "terrain/240x160"},
+                                       std::tuple<uint16_t, uint16_t, char const*>{640, 480, "terrain/640x480"}})
+        {
+            scenes.push_back({name, 0, [heights, colors, map, terrain, w, h](BenchContext& c, MatrixShader&, fren::DrawType, uint32_t frame)
+            {
+                if(c.width() != w || c.height() != h)
+                {
+                    c.setViewPort(w, h);
+                }
+                //the spans go straight to the backend, past an async raster thread
+                c.Finish();
+                if(terrain->threads() != c.rasterThreads())
+                {
+                    terrain->setThreads(c.rasterThreads());
+                }
+                fren::TerrainCamera const cam{fx(0.5f * frame), fx(-2.0f * frame), fx(200.0f), fx(0.004f * frame),
+                                              fx(h * 0.3f), fx(h * 0.5f), fx(800.0f)};
+                terrain->render(c, map, cam);
+            }, column_types});
+        }
+    }
+
+    return scenes;
+}
+
+auto run(Scene const& scene, fren::DrawType const dt, char const* dt_name, uint32_t const frames, uint32_t const threads,
+         fren::Precision const precision, bool const async, bool const optimize) -> Result
+{
+    BenchContext ctx;
+    MatrixShader shader;
+    ctx.setViewPort(640, 480);
+    ctx.setRasterThreads(threads);
+    ctx.setPrecision(precision);
+    ctx.setVertexFunction(&shader);
+    ctx.ColorPointer(nullptr);
+    ctx.setAsync(async);
+    ctx.setSegmentOptimization({.dedup = optimize, .merge = optimize});
+
+    //warm up so the stage buffers reach their steady state size, async until every command slot was used once
+    uint32_t const warmup = async ? 64 : 3;
+    for(uint32_t f = 0; f < warmup; ++f)
+    {
+        ctx.Clear();
+        scene.frame(ctx, shader, dt, f);
+        ctx.Present();
+    }
+    ctx.Finish();
+
+    ctx.resetStageTimes();
+    ctx.resetPipelineStats();
+    uint64_t const allocs = alloc_count;
+    auto const begin = std::chrono::steady_clock::now();
+    for(uint32_t f = 0; f < frames; ++f)
+    {
+        ctx.Clear();
+        scene.frame(ctx, shader, dt, f + warmup);
+        ctx.Present();
+    }
+    ctx.Finish();
+    auto const end = std::chrono::steady_clock::now();
+    uint64_t const frame_allocs = alloc_count - allocs;
+
+    Result r;
+    r.name = scene.name + "/" + dt_name;
+    r.vertices = uint64_t(scene.vertices) * frames;
+    //points and segments alike, so point draws stay comparable with line draws
+    r.segments = ctx.pipelineStats().segments + ctx.pipelineStats().points;
+    r.ns_per_frame = std::chrono::duration<double, std::nano>(end - begin).count() / frames;
+    r.allocs_per_frame = double(frame_allocs) / frames;
+    r.stage_ns = ctx.stageTimes();
+    r.stats = ctx.pipelineStats();
+    return r;
+}
+
+auto metrics(Result const& r, uint32_t const frames) -> std::map<std::string, double>
+{
+    double const seconds = r.ns_per_frame * frames * 1e-9;
+    std::map<std::string, double> m;
+    m["ns_per_frame"] = r.ns_per_frame;
+    m["vertices_per_s"] = seconds > 0 ? r.vertices / seconds : 0;
+    m["segments_per_s"] = seconds > 0 ? r.segments / seconds : 0;
+    m["segments_per_frame"] = double(r.segments) / frames;
+    m["allocs_per_frame"] = r.allocs_per_frame;
+    for(std::size_t s = 0; s < r.stage_ns.size(); ++s)
+    {
+        m[std::string("stage_ns.") + stage_names[s]] = double(r.stage_ns[s]) / frames;
+    }
+    for(auto const& [counter, name] : stat_names)
+    {
+        m[std::string("stats.") + name] = double(r.stats.*counter) / frames;
+    }
+    return m;
+}
+
+struct Threshold
+{
+    std::string result;
+    std::string metric;
+    double value;
+    bool is_min;
+};
+
+//name.metric=value, name may end in * to match a prefix
+auto parseThreshold(char const* arg, bool const is_min, Threshold& out) -> bool
+{
+    std::string const s(arg);
+    auto const eq = s.rfind('=');
+    if(eq == std::string::npos)
+    {
+        return false;
+    }
+    auto const dot = s.find('.');
+    if(dot == std::string::npos || dot > eq)
+    {
+        return false;
+    }
+    out.result = s.substr(0, dot);
+    out.metric = s.substr(dot + 1, eq - dot - 1);
+    out.value = std::strtod(s.c_str() + eq + 1, nullptr);
+    out.is_min = is_min;
+    return true;
+}
+
+auto matches(std::string const& pattern, std::string const& name) -> bool
+{
+    if(!pattern.empty() && pattern.back() == '*')
+    {
+        return name.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0;
+    }
+    return pattern == name;
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: fvecbench [--frames N] [--threads N] [--precision P] [--async] [--optimize] [--filter PREFIX]\n"
+                 "                 [--out FILE] [--min NAME.METRIC=VALUE] [--max NAME.METRIC=VALUE]\n"
+                 "NAME is scene/api/drawtype, a trailing * matches a prefix.\n"
+                 "METRIC is one of ns_per_frame, vertices_per_s, segments_per_s,\n"
+                 "segments_per_frame, allocs_per_frame, stage_ns.<stage> or\n"
+                 "stats.<counter>, counters are per frame.\n"
+                 "--threads rasterizes large draws in tiles on N threads.\n"
+                 "--precision runs the clip space pipeline in fixed, float or double.\n"
+                 "--async rasterizes and presents on a separate thread, overlapping the next frame.\n"
+                 "--optimize drops repeated segments and merges collinear ones before clipping.\n"
+                 "Exits with 1 when a threshold is violated.\n");
+}
+
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    uint32_t frames = 20;
+    uint32_t threads = 1;
+    std::size_t precision = 0;
+    bool async = false;
+    bool optimize = false;
+    std::string filter;
+    std::string out_path;
+    std::vector<Threshold> thresholds;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string const a = argv[i];
+        bool const has_value = i + 1 < argc;
+        Threshold t;
+        if(a == "--frames" && has_value)
+        {
+            frames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(a == "--threads" && has_value)
+        {
+            threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(a == "--precision" && has_value)
+        {
+            precision = findPrecision(argv[++i]);
+            if(precision == std::size(precisions))
+            {
+                usage();
+                return 2;
+            }
+        }
+        else if(a == "--async")
+        {
+            async = true;
+        }
+        else if(a == "--optimize")
+        {
+            optimize = true;
+        }
+        else if(a == "--filter" && has_value)
+        {
+            filter = argv[++i];
+        }
+        else if(a == "--out" && has_value)
+        {
+            out_path = argv[++i];
+        }
+        else if((a == "--min" || a == "--max") && has_value && parseThreshold(argv[++i], a == "--min", t))
+        {
+            thresholds.push_back(t);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    for(auto const& scene : makeScenes())
+    {
+        for(auto const& [dt, dt_name] : scene.types)
+        {
+            std::string const name = scene.name + "/" + dt_name;
+            if(!filter.empty() && name.compare(0, filter.size(), filter) != 0)
+            {
+                continue;
+            }
+            results.push_back(run(scene, dt, dt_name, frames, threads, precisions[precision].first, async, optimize));
+        }
+    }
+
+    FILE* out = stdout;
+    if(!out_path.empty())
+    {
+        out = std::fopen(out_path.c_str(), "w");
+        if(!out)
+        {
+            std::fprintf(stderr, "fvecbench: cannot open %s\n", out_path.c_str());
+            return 2;
+        }
+    }
+
+    int failures = 0;
+    std::fprintf(out, "{\n  \"frames\": %u,\n  \"threads\": %u,\n  \"precision\": \"%s\",\n  \"async\": %s,\n  \"optimize\": %s,\n"
+                 "  \"results\": [\n",
+                 frames, threads, precisions[precision].second, async ? "true" : "false", optimize ? "true" : "false");
+    for(std::size_t r = 0; r < results.size(); ++r)
+    {
+        auto const m = metrics(results[r], frames);
+        std::fprintf(out, "    {\"name\": \"%s\", \"vertices\": %llu, \"segments\": %llu",
+                     results[r].name.c_str(),
+                     static_cast<unsigned long long>(results[r].vertices),
+                     static_cast<unsigned long long>(results[r].segments));
+        for(auto const& [key, value] : m)
+        {
+            std::fprintf(out, ", \"%s\": %.3f", key.c_str(), value);
+        }
+        std::fprintf(out, "}%s\n", r + 1 < results.size() ? "," : "");
+
+        for(auto const& t : thresholds)
+        {
+            if(!matches(t.result, results[r].name))
+            {
+                continue;
+            }
+            auto const it = m.find(t.metric);
+            if(it == m.end())
+            {
+                std::fprintf(stderr, "fvecbench: unknown metric %s\n", t.metric.c_str());
+                ++failures;
+                continue;
+            }
+            if(t.is_min ? it->second < t.value : it->second > t.value)
+            {
+                std::fprintf(stderr, "fvecbench: %s.%s = %.3f, %s %.3f\n",
+                             results[r].name.c_str(), t.metric.c_str(), it->second,
+                             t.is_min ? "expected at least" : "expected at most", t.value);
+                ++failures;
+            }
+        }
+    }
+    std::fprintf(out, "  ]\n}\n");
+
+    if(out != stdout)
+    {
+        std::fclose(out);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+#include "frenfb.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//segments against the view volume in every precision, drawn into an 80x60 framebuffer
+//x = -1..1 maps to columns 0..80 and y = 1..-1 to rows 0..60, so the last visible column and row are 79 and 59
+
+namespace
+{
+
+using fren::math::vec2;
+
+constexpr uint16_t width = 80;
+constexpr uint16_t height = 60;
+
+int failures = 0;
+
+void check(char const* name, fren::Precision const p, bool const ok)
+{
+    char const* const precision[] = {"fixed", "float", "double"};
+    std::printf("%-36s %-6s %s\n", name, precision[static_cast<int>(p)], ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+struct Pixel
+{
+    uint16_t x, y;
+};
+
+//draws one segment and returns the lit pixels
+auto draw(fren::Precision const p, vec2 const a, vec2 const b) -> std::vector<Pixel>
+{
+    vec2 verts[2] = {a, b};
+    fren::FramebufferContext ctx;
+    fren::MatrixVertexFunction identity;
+    ctx.setViewPort(width, height);
+    ctx.setVertexFunction(&identity);
+    ctx.setPrecision(p);
+    ctx.ColorPointer(nullptr);
+    ctx.VertexPointer(2, verts);
+    ctx.clear();
+    ctx.DrawArray(fren::DrawType::Lines, 0, 2);
+
+    std::vector<Pixel> lit;
+    for(uint16_t y = 0; y < height; ++y)
+    {
+        for(uint16_t x = 0; x < width; ++x)
+        {
+            if(ctx.pixel(x, y) != 0)
+            {
+                lit.push_back({x, y});
+            }
+        }
+    }
+    return lit;
+}
+
+auto lit_at(std::vector<Pixel> const & lit, uint16_t const x, uint16_t const y0, uint16_t const y1) -> bool
+{
+    for(Pixel const & p : lit)
+    {
+        if(p.x == x && p.y >= y0 && p.y <= y1)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//both endpoints outside, on opposite sides, the part inside has to be drawn
+void test_crossing(fren::Precision const p)
+{
+    //a row at y = 0.25, every column once
+    std::vector<Pixel> const row = draw(p, {-3.0_fx, 0.25_fx}, {3.0_fx, 0.25_fx});
+    bool every_column = row.size() == width;
+    for(uint16_t x = 0; x < width; ++x)
+    {
+        every_column = every_column && lit_at(row, x, 22, 23);
+    }
+    check("crossing, horizontal", p, every_column);
+
+    //a diagonal through the centre whose endpoints are outside two planes each
+    std::vector<Pixel> const diagonal = draw(p, {-2.0_fx, -3.0_fx}, {2.0_fx, 3.0_fx});
+    check("crossing, diagonal", p, lit_at(diagonal, 40, 29, 31) && lit_at(diagonal, 20, 0, height - 1) && lit_at(diagonal, 60, 0, height - 1));
+}
+
+//both endpoints outside and the segment passes outside a corner, nothing is drawn
+void test_corner(fren::Precision const p)
+{
+    check("outside top right corner", p, draw(p, {0.6_fx, 1.6_fx}, {1.6_fx, 0.6_fx}).empty());
+    check("outside bottom left corner", p, draw(p, {-1.6_fx, -0.6_fx}, {-0.6_fx, -1.6_fx}).empty());
+}
+
+//one endpoint inside, the clipped end lands on the edge of the viewport
+void test_partial(fren::Precision const p)
+{
+    //leaves through the right plane at y = 0.2, row 24
+    std::vector<Pixel> const right = draw(p, {0.0_fx, 0.0_fx}, {3.0_fx, 0.6_fx});
+    bool inside = !right.empty();
+    for(Pixel const & px : right)
+    {
+        inside = inside && px.x >= 40;
+    }
+    check("partial, right edge", p, inside && lit_at(right, 40, 30, 30) && lit_at(right, width - 1, 23, 25));
+
+    //leaves through the top plane at x = 2/15, column 45
+    std::vector<Pixel> const top = draw(p, {0.1_fx, 0.0_fx}, {0.2_fx, 3.0_fx});
+    bool below = !top.empty();
+    for(Pixel const & px : top)
+    {
+        below = below && px.y <= 30;
+    }
+    bool edge = false;
+    for(Pixel const & px : top)
+    {
+        edge = edge || (px.y == 0 && std::abs(px.x - 45) <= 1);
+    }
+    check("partial, top edge", p, below && edge);
+}
+
+}
+
+auto main() -> int
+{
+    for(fren::Precision const p : {fren::Precision::Fixed, fren::Precision::Float, fren::Precision::Double})
+    {
+        test_crossing(p);
+        test_corner(p);
+        test_partial(p);
+    }
+    return failures ? 1 : 0;
+}
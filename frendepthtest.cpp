@@ -0,0 +1,207 @@
+#include "frenfb.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//the depth tested paths of FramebufferContext against a plain per pixel reference, serial and on raster threads
+//the reference steps z in 16.16 along its own bresenham and keeps a whole depth buffer, cleared in full,
+//so the per tile cleared flags must read back exactly like a buffer that was filled with UINT16_MAX
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec3;
+
+int failures = 0;
+
+//points reach lineDepth() as segments of no length through the default points()
+class Reference : public fren::FramebufferContext
+{
+public:
+    std::vector<uint16_t> z;
+
+    void lineDepth(uint16_t x1, uint16_t y1, uint16_t z1, uint16_t x2, uint16_t y2, uint16_t z2, uint16_t color) override
+    {
+        if(z.size() != std::size_t(xres) * yres)
+        {
+            z.assign(std::size_t(xres) * yres, UINT16_MAX);
+        }
+
+        int32_t const dx = std::abs(x2 - x1);
+        int32_t const dy = std::abs(y2 - y1);
+        bool const x_major = dx >= dy;
+        int32_t const steps = x_major ? dx : dy;
+        int32_t const minor = x_major ? dy : dx;
+        int32_t const step_major = (x_major ? x2 < x1 : y2 < y1) ? -1 : 1;
+        int32_t const step_minor = (x_major ? y2 < y1 : x2 < x1) ? -1 : 1;
+        int64_t const dz = steps ? (int64_t(z2) - z1) * 65536 / steps : 0;
+
+        int32_t a = x_major ? x1 : y1;
+        int32_t b = x_major ? y1 : x1;
+        int32_t error = 2 * minor - steps;
+        for(int32_t j = 0; j <= steps; ++j)
+        {
+            int32_t const x = x_major ? a : b;
+            int32_t const y = x_major ? b : a;
+            uint16_t const depth = static_cast<uint16_t>(uint32_t((int64_t(z1) << 16) + 0x8000 + dz * j) >> 16);
+            if(x < xres && y < yres && depth <= z[std::size_t(y) * xres + x])
+            {
+                z[std::size_t(y) * xres + x] = depth;
+                pixels[std::size_t(y) * stride + x] = color;
+            }
+            if(error > 0)
+            {
+                b += step_minor;
+                error -= 2 * steps;
+            }
+            error += 2 * minor;
+            a += step_major;
+        }
+    }
+
+    void points(fren::VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        Context::points(in, first, count);
+    }
+
+    void clearDepth()
+    {
+        FramebufferContext::clearDepth();
+        std::fill(z.begin(), z.end(), UINT16_MAX);
+    }
+
+    void clear() override
+    {
+        FramebufferContext::clear();
+        std::fill(z.begin(), z.end(), UINT16_MAX);
+    }
+};
+
+//vertices anywhere in and around the view volume, or only in the lower left corner so most tiles stay cleared
+auto scene(uint32_t const seed, uint32_t const n, bool const corner) -> std::vector<vec3>
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xy(corner ? -1.1f : -1.3f, corner ? -0.6f : 1.3f);
+    std::uniform_real_distribution<float> z(-1.1f, 1.1f);
+    std::vector<vec3> v(n);
+    for(vec3& p : v)
+    {
+        p = {{fixed32(xy(rng)), fixed32(xy(rng))}, fixed32(z(rng))};
+    }
+    return v;
+}
+
+auto same(char const* name, uint32_t const threads, fren::FramebufferContext const & a, Reference const & r) -> void
+{
+    uint32_t pixels = 0;
+    uint32_t depths = 0;
+    for(uint16_t y = 0; y < a.height(); ++y)
+    {
+        for(uint16_t x = 0; x < a.width(); ++x)
+        {
+            uint16_t const z = r.z.empty() ? UINT16_MAX : r.z[std::size_t(y) * a.width() + x];
+            pixels += a.pixel(x, y) != r.pixel(x, y) ? 1 : 0;
+            depths += a.depth(x, y) != z ? 1 : 0;
+        }
+    }
+    bool const ok = pixels == 0 && depths == 0;
+    std::printf("%-44s threads %u %s\n", name, threads, ok ? "ok" : "FAILED");
+    if(!ok)
+    {
+        std::printf("    %u pixels and %u depth values differ\n", pixels, depths);
+    }
+    failures += ok ? 0 : 1;
+}
+
+void run(uint32_t const threads)
+{
+    std::vector<uint16_t> colors(6000);
+    std::mt19937 rng(3);
+    for(uint16_t& c : colors)
+    {
+        c = static_cast<uint16_t>(rng() & 0x7FFF);
+    }
+    std::vector<vec3> wide = scene(3, 6000, false);
+    std::vector<vec3> other = scene(4, 6000, false);
+    std::vector<vec3> corner = scene(5, 3000, true);
+
+    fren::MatrixVertexFunction identity;
+    fren::FramebufferContext ctx;
+    Reference ref;
+    ctx.setRasterThreads(threads);
+
+    auto const each = [&](auto const & f)
+    {
+        f(static_cast<fren::FramebufferContext&>(ctx));
+        f(static_cast<fren::FramebufferContext&>(ref));
+    };
+    auto const draw = [&](std::vector<vec3>& v, fren::DrawType const dt, uint32_t const n)
+    {
+        each([&](fren::FramebufferContext& c)
+        {
+            c.VertexPointer(3, v.data());
+            c.DrawArray(dt, 0, n);
+        });
+    };
+
+    each([&](fren::FramebufferContext& c)
+    {
+        c.setViewPort(300, 200);
+        c.setVertexFunction(&identity);
+        c.ColorPointer(colors.data());
+        c.setDepthTest(true);
+        c.clear();
+    });
+    draw(wide, fren::DrawType::Lines, 6000);
+    draw(wide, fren::DrawType::Points, 600);
+    same("lines and points", threads, ctx, ref);
+
+    //a full clear, then only the tiles of the corner are filled and every other one has to read as cleared
+    ctx.clear();
+    ref.clear();
+    draw(corner, fren::DrawType::Lines, 3000);
+    same("corner after clear", threads, ctx, ref);
+
+    //depth cleared without the colors, the next draw tests against nothing but keeps the corner pixels it misses
+    ctx.clearDepth();
+    ref.clearDepth();
+    draw(other, fren::DrawType::Line_Strip, 3000);
+    same("strip after clearDepth", threads, ctx, ref);
+
+    //no clear, depth accumulates over draws
+    draw(wide, fren::DrawType::Lines, 6000);
+    draw(other, fren::DrawType::Points, 6000);
+    same("lines over strip without clear", threads, ctx, ref);
+
+    //draws without depth testing leave the depth buffer alone
+    each([](fren::FramebufferContext& c) { c.setDepthTest(false); });
+    draw(corner, fren::DrawType::Lines, 3000);
+    each([](fren::FramebufferContext& c) { c.setDepthTest(true); });
+    draw(other, fren::DrawType::Lines, 6000);
+    same("depth off in between", threads, ctx, ref);
+
+    //a viewport change sizes the buffer again and nothing of the old one shows through
+    each([](fren::FramebufferContext& c)
+    {
+        c.setViewPort(130, 250);
+        c.clear();
+    });
+    draw(other, fren::DrawType::Line_Loop, 2000);
+    draw(wide, fren::DrawType::Lines, 6000);
+    same("line loop and lines after viewport change", threads, ctx, ref);
+}
+
+}
+
+auto main() -> int
+{
+    for(uint32_t const threads : {1u, 4u})
+    {
+        run(threads);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+#include "frenfb.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+//DrawElements with a few indices far into a large vertex array against DrawArray over the same vertices packed together
+//the gather tables have to stay sized by the index count and not by the largest index
+//needs FREN_PIPELINE_STATS for the shaded count
+
+//the largest single heap request since the last reset
+static std::size_t largest_alloc = 0;
+
+void* operator new(std::size_t n)
+{
+    largest_alloc = std::max(largest_alloc, n);
+    if(void* p = std::malloc(n ? n : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+//the replacement above allocates with malloc, so free is the matching release,
+//gcc only sees free paired with a new expression and warns
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+
+constexpr uint16_t width = 160;
+constexpr uint16_t height = 120;
+
+int failures = 0;
+
+void check(char const* name, bool const ok)
+{
+    std::printf("%-44s %s\n", name, ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+auto same_pixels(fren::FramebufferContext const & a, fren::FramebufferContext const & b) -> bool
+{
+    uint32_t lit = 0;
+    for(uint16_t y = 0; y < height; ++y)
+    {
+        for(uint16_t x = 0; x < width; ++x)
+        {
+            if(a.pixel(x, y) != b.pixel(x, y))
+            {
+                return false;
+            }
+            lit += a.pixel(x, y) != 0 ? 1 : 0;
+        }
+    }
+    return lit > 0;
+}
+
+//draws indices into verts as lines and the vertices they name in order as an array
+void compare(char const* name, std::vector<vec2>& verts, std::vector<uint32_t>& indices, uint32_t const unique)
+{
+    std::vector<vec2> packed;
+    for(uint32_t const i : indices)
+    {
+        packed.push_back(verts[i]);
+    }
+
+    fren::MatrixVertexFunction identity;
+    fren::FramebufferContext elements, array;
+    for(fren::FramebufferContext* ctx : {&elements, &array})
+    {
+        ctx->setViewPort(width, height);
+        ctx->setVertexFunction(&identity);
+        ctx->ColorPointer(nullptr);
+        ctx->clear();
+    }
+    array.VertexPointer(2, packed.data());
+    array.DrawArray(fren::DrawType::Lines, 0, packed.size());
+
+    //twice, the second draw runs on the tables the first one left
+    elements.VertexPointer(2, verts.data());
+    elements.IndexPointer(indices.data());
+    largest_alloc = 0;
+    elements.DrawElements(fren::DrawType::Lines, indices.size());
+    elements.resetPipelineStats();
+    elements.DrawElements(fren::DrawType::Lines, indices.size());
+
+    std::printf("%s: largest allocation %zu bytes\n", name, largest_alloc);
+    check(name, same_pixels(elements, array) && elements.pipelineStats().shaded == unique && largest_alloc < (std::size_t(1) << 20));
+}
+
+}
+
+auto main() -> int
+{
+    //4 million vertices, direct tables over their indices would take 32 MB
+    std::vector<vec2> verts(std::size_t(1) << 22);
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> xy(-1.2f, 1.2f);
+    for(vec2& v : verts)
+    {
+        v = {fixed32(xy(rng)), fixed32(xy(rng))};
+    }
+
+    //a square at the far end of the array, every corner used twice
+    uint32_t const last = static_cast<uint32_t>(verts.size() - 1);
+    std::vector<uint32_t> square = {last - 3, last - 2, last - 2, last - 1, last - 1, last, last, last - 3};
+    compare("square at the end of the array", verts, square, 4);
+
+    //random indices all over the array, some repeated, some below the direct table limit
+    std::vector<uint32_t> scattered;
+    std::uniform_int_distribution<uint32_t> any(0, last);
+    std::uniform_int_distribution<uint32_t> low(0, 1000);
+    for(uint32_t i = 0; i < 3000; ++i)
+    {
+        uint32_t const r = rng() % 8;
+        scattered.push_back(r == 0 && !scattered.empty() ? scattered[rng() % scattered.size()] : r == 1 ? low(rng) : any(rng));
+    }
+    std::vector<uint32_t> distinct = scattered;
+    std::sort(distinct.begin(), distinct.end());
+    uint32_t const unique = static_cast<uint32_t>(std::unique(distinct.begin(), distinct.end()) - distinct.begin());
+    compare("scattered indices with repeats", verts, scattered, unique);
+    return failures ? 1 : 0;
+}
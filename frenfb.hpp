@@ -0,0 +1,1009 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fren.hpp"
+#include "frenpool.hpp"
+
+namespace fren
+{
+
+//fills n pixels, memset when both bytes of the color match, otherwise 16 byte stores
+inline void fill16(uint16_t* dst, std::size_t n, uint16_t const color)
+{
+    if((color & 0xFF) == (color >> 8))
+    {
+        std::memset(dst, color & 0xFF, n * sizeof(uint16_t));
+        return;
+    }
+
+#if defined(__SSE2__)
+    __m128i const c = _mm_set1_epi16(static_cast<int16_t>(color));
+    while(n && (reinterpret_cast<std::uintptr_t>(dst) & 15))
+    {
+        *dst++ = color;
+        --n;
+    }
+    for(; n >= 16; n -= 16, dst += 16)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst), c);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + 8), c);
+    }
+#endif
+    std::fill_n(dst, n, color);
+}
+
+//headless backend, renders into a 16 bit 555 buffer
+//the buffer is owned and sized by setViewPort unless caller memory is given to setFramebuffer
+class FramebufferContext : public Context
+{
+public:
+
+    FramebufferContext()
+    {
+        pixels = nullptr;
+        stride = 0;
+        clear_color = 0;
+    }
+
+    ~FramebufferContext() override
+    {
+        setAsync(false);
+    }
+
+    void setViewPort(const uint16_t x, const uint16_t y) override
+    {
+        Context::setViewPort(x, y);
+        if(pixels == nullptr || pixels == owned.data())
+        {
+            owned.resize(std::size_t(x) * y);
+            pixels = owned.data();
+            stride = x;
+        }
+    }
+
+    //render into caller memory, pitch is in pixels and must be >= width
+    //passing nullptr switches back to the owned buffer
+    void setFramebuffer(uint16_t* buffer, const uint16_t width, const uint16_t height, const uint32_t pitch)
+    {
+        Finish();
+        if(buffer == nullptr)
+        {
+            pixels = nullptr;
+            setViewPort(width, height);
+            return;
+        }
+        pixels = buffer;
+        stride = pitch;
+        Context::setViewPort(width, height);
+    }
+
+    //waits for the raster thread in async mode, like the other setters below
+    void setClearColor(uint16_t const color)
+    {
+        Finish();
+        clear_color = color;
+    }
+
+    //rasterize large draws on n threads in 64x64 pixel tiles, 1 keeps the serial line() path
+    //output is identical to the serial path, but the tiled path writes the buffer itself
+    //so subclasses that override line() should leave this at 1
+    //triangles always go through the block rasterizer, large triangle draws split into 64 row bands
+    void setRasterThreads(uint32_t const n)
+    {
+        Finish();
+        pool = n > 1 ? std::make_unique<WorkerPool>(n) : nullptr;
+    }
+
+    auto rasterThreads() const -> uint32_t
+    {
+        return pool ? pool->size() : 1;
+    }
+
+    auto data() -> uint16_t* { return pixels; }
+    auto data() const -> uint16_t const* { return pixels; }
+    auto pitch() const -> uint32_t { return stride; }
+
+    auto pixel(uint16_t x, uint16_t y) const -> uint16_t
+    {
+        return pixels[std::size_t(y) * stride + x];
+    }
+
+    //depth buffer value of pixel x, y, UINT16_MAX where nothing was drawn since the last clear or viewport change
+    auto depth(uint16_t x, uint16_t y) const -> uint16_t
+    {
+        if(depth_valid.empty() || !depth_sized() || !depth_valid[(y >> TILE_SHIFT) * depth_tiles_x + (x >> TILE_SHIFT)])
+        {
+            return UINT16_MAX;
+        }
+        return depth_buffer[std::size_t(y) * xres + x];
+    }
+
+    void plot(uint16_t x, uint16_t y, uint16_t color) override
+    {
+        if(x < xres && y < yres)
+        {
+            pixels[std::size_t(y) * stride + x] = color;
+            tally(&PipelineStats::pixels, 1);
+        }
+    }
+
+    //one pixel per point, depth tested like a lineDepth() of no length while depth testing
+    void points(VertexStream const & in, uint32_t const first, uint32_t const n) override
+    {
+        if(pixels == nullptr || xres == 0 || yres == 0)
+        {
+            return;
+        }
+        if(depth_test)
+        {
+            reserve_depth();
+        }
+
+        uint64_t written = 0;
+        uint64_t occluded = 0;
+        for(uint32_t i = first; i < first + n; ++i)
+        {
+            uint16_t const x = static_cast<int16_t>(math::fromRaw(in.x[i]));
+            uint16_t const y = static_cast<int16_t>(math::fromRaw(in.y[i]));
+            if(x >= xres || y >= yres)
+            {
+                continue;
+            }
+            if(depth_test)
+            {
+                touch_depth(x, y, x, y);
+                uint16_t const z = window_depth(in.z[i]);
+                uint16_t& d = depth_buffer[std::size_t(y) * xres + x];
+                if(z > d)
+                {
+                    ++occluded;
+                    continue;
+                }
+                d = z;
+            }
+            pixels[std::size_t(y) * stride + x] = in.col[i];
+            ++written;
+        }
+        tally(&PipelineStats::pixels, written);
+        tally(&PipelineStats::occluded, occluded);
+    }
+
+    void line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) override
+    {
+        if(y1 == y2)
+        {
+            lineHorizontal(x1, y1, x2, color);
+        }
+        else if(x1 == x2)
+        {
+            lineVertical(x1, y1, y2, color);
+        }
+        else if(x1 < xres && x2 < xres && y1 < yres && y2 < yres)
+        {
+            bresenham<false>(x1, y1, x2, y2, color);
+            tally(&PipelineStats::pixels, std::max(std::abs(x2 - x1), std::abs(y2 - y1)) + 1);
+        }
+        else
+        {
+            bresenham<true>(x1, y1, x2, y2, color);
+        }
+    }
+
+    //passes where the interpolated depth is less or equal to the buffer, which then takes it
+    void lineDepth(uint16_t x1, uint16_t y1, uint16_t z1, uint16_t x2, uint16_t y2, uint16_t z2, uint16_t color) override
+    {
+        if(pixels == nullptr || xres == 0 || yres == 0)
+        {
+            return;
+        }
+        reserve_depth();
+        touch_depth(std::min<int32_t>(std::min(x1, x2), xres - 1), std::min<int32_t>(std::min(y1, y2), yres - 1),
+                    std::min<int32_t>(std::max(x1, x2), xres - 1), std::min<int32_t>(std::max(y1, y2), yres - 1));
+        uint64_t occluded = 0;
+        uint32_t const written = x1 < xres && x2 < xres && y1 < yres && y2 < yres
+                               ? bresenham_depth(x1, y1, z1, x2, y2, z2, color, occluded)
+                               : raster_segment<true>(walk({x1, y1, x2, y2}), color, z1, z2, 0, 0, xres - 1, yres - 1, occluded);
+        tally(&PipelineStats::pixels, written);
+        tally(&PipelineStats::occluded, occluded);
+    }
+
+    void lineHorizontal(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t color) override
+    {
+        if(y1 >= yres || xres == 0)
+        {
+            return;
+        }
+        if(x1 > x2)
+        {
+            std::swap(x1, x2);
+        }
+        if(x1 >= xres)
+        {
+            return;
+        }
+        x2 = std::min<uint16_t>(x2, xres - 1);
+        fill16(pixels + std::size_t(y1) * stride + x1, x2 - x1 + 1, color);
+        tally(&PipelineStats::pixels, x2 - x1 + 1);
+    }
+
+    void lineVertical(uint16_t x1, uint16_t y1, uint16_t y2, uint16_t color) override
+    {
+        if(x1 >= xres || yres == 0)
+        {
+            return;
+        }
+        if(y1 > y2)
+        {
+            std::swap(y1, y2);
+        }
+        if(y1 >= yres)
+        {
+            return;
+        }
+        y2 = std::min<uint16_t>(y2, yres - 1);
+
+        uint16_t* p = pixels + std::size_t(y1) * stride + x1;
+        for(uint32_t n = y2 - y1 + 1; n; --n, p += stride)
+        {
+            *p = color;
+        }
+        tally(&PipelineStats::pixels, y2 - y1 + 1);
+    }
+
+    //marks every depth tile as cleared, a tile is filled with UINT16_MAX when a depth test first reads it
+    void clearDepth()
+    {
+        std::fill(depth_valid.begin(), depth_valid.end(), 0);
+    }
+
+    //clears the depth buffer as well
+    void clear() override
+    {
+        clearDepth();
+        if(pixels == nullptr)
+        {
+            return;
+        }
+        if(stride == xres)
+        {
+            fill16(pixels, std::size_t(xres) * yres, clear_color);
+            return;
+        }
+        for(uint16_t y = 0; y < yres; ++y)
+        {
+            fill16(pixels + std::size_t(y) * stride, xres, clear_color);
+        }
+    }
+
+    //draws with at least PARALLEL_MIN_SEGMENTS segments take the tiled path once raster threads are set
+    void lines(VertexStream const & in, uint32_t const first, uint32_t const n) override
+    {
+        uint32_t const segments = n / 2;
+        if(!pool || segments < PARALLEL_MIN_SEGMENTS || pixels == nullptr || xres == 0 || yres == 0)
+        {
+            Context::lines(in, first, n);
+            return;
+        }
+
+        uint32_t const tiles_x = (xres + TILE_SIZE - 1) >> TILE_SHIFT;
+        uint32_t const tiles_y = (yres + TILE_SIZE - 1) >> TILE_SHIFT;
+        uint32_t const tiles = tiles_x * tiles_y;
+        uint32_t const chunks = pool->size();
+        uint32_t const per_chunk = (segments + chunks - 1) / chunks;
+        if(bins.size() < chunks * tiles)
+        {
+            bins.resize(chunks * tiles);
+        }
+        screen_segments.resize(segments);
+        if(depth_test)
+        {
+            reserve_depth();
+        }
+#if defined(FREN_PIPELINE_STATS)
+        tile_pixels.resize(std::max<std::size_t>(tile_pixels.size(), tiles));
+        tile_occluded.resize(std::max<std::size_t>(tile_occluded.size(), tiles));
+#endif
+
+        //bin in parallel, each chunk owns its row of bins
+        pool->run(chunks, [&](uint32_t const c)
+        {
+            std::vector<uint32_t>* const b = bins.data() + c * tiles;
+            for(uint32_t t = 0; t < tiles; ++t)
+            {
+                b[t].clear();
+            }
+            uint32_t const end = std::min(segments, (c + 1) * per_chunk);
+            for(uint32_t s = c * per_chunk; s < end; ++s)
+            {
+                screen_segments[s] = screen_segment(in, first + s * 2);
+                bin_segment(walk(screen_segments[s]), s, b, tiles_x);
+            }
+        });
+
+        //rasterize in parallel, each tile is owned by the one thread that runs it
+        pool->run(tiles, [&](uint32_t const t)
+        {
+            int32_t const x0 = (t % tiles_x) << TILE_SHIFT;
+            int32_t const y0 = (t / tiles_x) << TILE_SHIFT;
+            int32_t const x1 = std::min<int32_t>(x0 + TILE_SIZE, xres) - 1;
+            int32_t const y1 = std::min<int32_t>(y0 + TILE_SIZE, yres) - 1;
+            uint64_t written = 0;
+            uint64_t occluded = 0;
+            if(depth_test)
+            {
+                touch_depth(x0, y0, x1, y1);
+            }
+            for(uint32_t c = 0; c < chunks; ++c)
+            {
+                for(uint32_t const s : bins[c * tiles + t])
+                {
+                    uint32_t const i = first + s * 2;
+                    if(depth_test)
+                    {
+                        written += raster_segment<true>(walk(screen_segments[s]), in.col[i], window_depth(in.z[i]), window_depth(in.z[i+1]),
+                                                        x0, y0, x1, y1, occluded);
+                    }
+                    else
+                    {
+                        written += raster_segment<false>(walk(screen_segments[s]), in.col[i], 0, 0, x0, y0, x1, y1, occluded);
+                    }
+                }
+            }
+#if defined(FREN_PIPELINE_STATS)
+            tile_pixels[t] = written;
+            tile_occluded[t] = occluded;
+#else
+            (void)written;
+#endif
+        });
+
+#if defined(FREN_PIPELINE_STATS)
+        for(uint32_t t = 0; t < tiles; ++t)
+        {
+            tally(&PipelineStats::pixels, tile_pixels[t]);
+            tally(&PipelineStats::occluded, tile_occluded[t]);
+        }
+#endif
+    }
+
+    //edge function rasterizer over 8x8 pixel blocks, blocks outside an edge are skipped,
+    //blocks inside all three are filled whole and only blocks an edge crosses are tested per pixel, 8 at a time with sse2
+    //covers the same pixels as the lineHorizontal spans of Context::triangles
+    void triangles(VertexStream const & in, uint32_t const first, uint32_t const n) override
+    {
+        if(pixels == nullptr)
+        {
+            return;
+        }
+
+        triangle_setups.clear();
+        uint64_t area = 0;
+        TriangleSetup t;
+        for(uint32_t i = first; i + 2 < first + n; i = i + 3)
+        {
+            if(t.setup(in, i, xres, yres))
+            {
+                triangle_setups.push_back(t);
+                area += uint64_t(t.xmax - t.xmin + 1) * uint64_t(t.ymax - t.ymin + 1);
+            }
+        }
+
+        if(!pool || area < PARALLEL_MIN_PIXELS)
+        {
+            uint64_t written = 0;
+            for(TriangleSetup const & s : triangle_setups)
+            {
+                written += raster_triangle(s, 0, yres - 1);
+            }
+            tally(&PipelineStats::pixels, written);
+            return;
+        }
+
+        //each band of rows is owned by the one thread that runs it and draws every triangle in order
+        uint32_t const bands = (yres + TILE_SIZE - 1) >> TILE_SHIFT;
+#if defined(FREN_PIPELINE_STATS)
+        tile_pixels.resize(std::max<std::size_t>(tile_pixels.size(), bands));
+#endif
+        pool->run(bands, [&](uint32_t const b)
+        {
+            int32_t const y0 = b << TILE_SHIFT;
+            int32_t const y1 = std::min<int32_t>(y0 + TILE_SIZE, yres) - 1;
+            uint64_t written = 0;
+            for(TriangleSetup const & s : triangle_setups)
+            {
+                written += raster_triangle(s, y0, y1);
+            }
+#if defined(FREN_PIPELINE_STATS)
+            tile_pixels[b] = written;
+#else
+            (void)written;
+#endif
+        });
+
+#if defined(FREN_PIPELINE_STATS)
+        for(uint32_t b = 0; b < bands; ++b)
+        {
+            tally(&PipelineStats::pixels, tile_pixels[b]);
+        }
+#endif
+    }
+
+protected:
+
+    std::vector<uint16_t> owned;
+    uint16_t* pixels;
+    uint32_t stride;
+    uint16_t clear_color;
+
+    static constexpr uint32_t TILE_SHIFT = 6;
+    static constexpr uint32_t TILE_SIZE = 1 << TILE_SHIFT;
+
+    //below this many segments a draw is not worth waking the pool for
+    static constexpr uint32_t PARALLEL_MIN_SEGMENTS = 1024;
+    //the same for the summed bounding boxes of a triangle draw
+    static constexpr uint64_t PARALLEL_MIN_PIXELS = 1 << 16;
+
+    static constexpr int32_t BLOCK = 8;
+
+    std::unique_ptr<WorkerPool> pool;
+
+    //a bresenham line as major and minor axis, so a tile can start it at any step
+    //moves(j) reproduces the error term walk of bresenham() exactly
+    struct Walk
+    {
+        int32_t a0, b0;         //start on the major and minor axis
+        int32_t sa, sb;
+        int32_t length, minor;  //steps along the major and minor axis
+        bool x_major;
+
+        auto moves(int64_t const j) const -> int32_t
+        {
+            return j ? static_cast<int32_t>((2 * int64_t(minor) * j + length - 1) / (2 * int64_t(length))) : 0;
+        }
+
+        //steps j whose major coordinate falls in [lo, hi], empty when first > last
+        void steps(int32_t const lo, int32_t const hi, int32_t& first, int32_t& last) const
+        {
+            first = std::max(0, sa > 0 ? lo - a0 : a0 - hi);
+            last = std::min(length, sa > 0 ? hi - a0 : a0 - lo);
+        }
+    };
+
+    //segment indices per binning chunk and tile, chunk major
+    //a tile walks the chunks in order, which keeps draw order within the tile
+    std::vector<std::vector<uint32_t>> bins;
+
+    //the coordinates Context::lines passes to line()
+    struct ScreenSegment
+    {
+        uint16_t x0, y0, x1, y1;
+    };
+    std::vector<ScreenSegment> screen_segments;
+
+    //pixels written and occluded per tile, summed into the stats after the raster pass
+    std::vector<uint64_t> tile_pixels;
+    std::vector<uint64_t> tile_occluded;
+
+    //xres * yres depth values, allocated by the first depth tested draw
+    //per 64x64 tile a flag whether the tile was filled since clearDepth, draws fill the tiles they may touch first
+    //the tiles line up with the raster tiles, so the tiled path fills each one from the thread that owns it
+    std::vector<uint16_t> depth_buffer;
+    std::vector<uint8_t> depth_valid;
+    uint32_t depth_tiles_x = 0;
+
+    std::vector<TriangleSetup> triangle_setups;
+
+    //false after a viewport change until the next depth tested draw sizes the buffer again
+    auto depth_sized() const -> bool
+    {
+        return depth_buffer.size() == std::size_t(xres) * yres && depth_tiles_x == ((xres + TILE_SIZE - 1) >> TILE_SHIFT);
+    }
+
+    //sizes the depth buffer to the viewport, all tiles start cleared
+    void reserve_depth()
+    {
+        if(depth_sized())
+        {
+            return;
+        }
+        depth_buffer.resize(std::size_t(xres) * yres);
+        depth_tiles_x = (xres + TILE_SIZE - 1) >> TILE_SHIFT;
+        depth_valid.assign(depth_tiles_x * ((yres + TILE_SIZE - 1) >> TILE_SHIFT), 0);
+    }
+
+    //fills the cleared depth tiles overlapping pixels x0..x1, y0..y1, which must lie in the viewport
+    void touch_depth(int32_t const x0, int32_t const y0, int32_t const x1, int32_t const y1)
+    {
+        for(int32_t ty = y0 >> TILE_SHIFT; ty <= y1 >> TILE_SHIFT; ++ty)
+        {
+            for(int32_t tx = x0 >> TILE_SHIFT; tx <= x1 >> TILE_SHIFT; ++tx)
+            {
+                uint8_t& valid = depth_valid[ty * depth_tiles_x + tx];
+                if(valid)
+                {
+                    continue;
+                }
+                int32_t const px = tx << TILE_SHIFT;
+                int32_t const py = ty << TILE_SHIFT;
+                int32_t const w = std::min<int32_t>(TILE_SIZE, xres - px);
+                for(int32_t r = py; r < std::min<int32_t>(py + TILE_SIZE, yres); ++r)
+                {
+                    fill16(depth_buffer.data() + std::size_t(r) * xres + px, w, UINT16_MAX);
+                }
+                valid = 1;
+            }
+        }
+    }
+
+    static auto screen_segment(VertexStream const & in, uint32_t const i) -> ScreenSegment
+    {
+        return {static_cast<uint16_t>(static_cast<int16_t>(math::fromRaw(in.x[i]))),
+                static_cast<uint16_t>(static_cast<int16_t>(math::fromRaw(in.y[i]))),
+                static_cast<uint16_t>(static_cast<int16_t>(math::fromRaw(in.x[i+1]))),
+                static_cast<uint16_t>(static_cast<int16_t>(math::fromRaw(in.y[i+1])))};
+    }
+
+    static auto walk(ScreenSegment const & seg) -> Walk
+    {
+        int32_t const x0 = seg.x0;
+        int32_t const y0 = seg.y0;
+        int32_t const x1 = seg.x1;
+        int32_t const y1 = seg.y1;
+        int32_t const dx = std::abs(x1 - x0);
+        int32_t const dy = std::abs(y1 - y0);
+        int32_t const sx = x1 < x0 ? -1 : 1;
+        int32_t const sy = y1 < y0 ? -1 : 1;
+
+        if(dx >= dy)
+        {
+            return {x0, y0, sx, sy, dx, dy, true};
+        }
+        return {y0, x0, sy, sx, dy, dx, false};
+    }
+
+    //adds segment s to every tile its pixels touch, one major axis tile span at a time
+    void bin_segment(Walk const & w, uint32_t const s, std::vector<uint32_t>* const b, uint32_t const tiles_x) const
+    {
+        int32_t const major_res = w.x_major ? xres : yres;
+        int32_t const minor_res = w.x_major ? yres : xres;
+        int32_t const a1 = w.a0 + w.sa * w.length;
+        int32_t const b1 = w.b0 + w.sb * w.minor;
+
+        //most segments are short and sit in a single tile
+        if(std::max(w.a0, a1) < major_res && std::max(w.b0, b1) < minor_res &&
+           (w.a0 >> TILE_SHIFT) == (a1 >> TILE_SHIFT) && (w.b0 >> TILE_SHIFT) == (b1 >> TILE_SHIFT))
+        {
+            int32_t const ta = w.a0 >> TILE_SHIFT;
+            int32_t const tb = w.b0 >> TILE_SHIFT;
+            b[w.x_major ? tb * tiles_x + ta : ta * tiles_x + tb].push_back(s);
+            return;
+        }
+
+        int32_t const lo = std::max(0, std::min(w.a0, a1));
+        int32_t const hi = std::min(major_res - 1, std::max(w.a0, a1));
+
+        for(int32_t ta = lo >> TILE_SHIFT; ta <= hi >> TILE_SHIFT; ++ta)
+        {
+            int32_t first, last;
+            w.steps(ta << TILE_SHIFT, (ta << TILE_SHIFT) + TILE_SIZE - 1, first, last);
+            if(first > last)
+            {
+                continue;
+            }
+
+            int32_t const bf = w.b0 + w.sb * w.moves(first);
+            int32_t const bl = w.b0 + w.sb * w.moves(last);
+            int32_t const bmin = std::max(0, std::min(bf, bl));
+            int32_t const bmax = std::min(minor_res - 1, std::max(bf, bl));
+            for(int32_t tb = bmin >> TILE_SHIFT; bmin <= bmax && tb <= bmax >> TILE_SHIFT; ++tb)
+            {
+                uint32_t const t = w.x_major ? tb * tiles_x + ta : ta * tiles_x + tb;
+                b[t].push_back(s);
+            }
+        }
+    }
+
+    //the pixels of the segment inside the tile x0..x1, y0..y1, returns how many were written
+    //with Depth, z0 and z1 are interpolated along the major axis in 16.16 and tested against the depth buffer,
+    //pixels failing the test are added to occluded
+    template<bool Depth>
+    auto raster_segment(Walk const & w, uint16_t const color, uint16_t const z0, uint16_t const z1,
+                        int32_t const x0, int32_t const y0, int32_t const x1, int32_t const y1, uint64_t& occluded) -> uint32_t
+    {
+        int32_t const blo = w.x_major ? y0 : x0;
+        int32_t const bhi = w.x_major ? y1 : x1;
+        int32_t first, last;
+        w.steps(w.x_major ? x0 : y0, w.x_major ? x1 : y1, first, last);
+        if(first > last)
+        {
+            return 0;
+        }
+
+        if(!Depth && w.minor == 0)
+        {
+            //axis aligned, one run of pixels
+            if(w.b0 < blo || w.b0 > bhi)
+            {
+                return 0;
+            }
+            int32_t const a = w.sa > 0 ? w.a0 + first : w.a0 - last;
+            uint16_t* const p = w.x_major ? pixels + std::size_t(w.b0) * stride + a
+                                          : pixels + std::size_t(a) * stride + w.b0;
+            if(w.x_major)
+            {
+                fill16(p, last - first + 1, color);
+            }
+            else
+            {
+                for(int32_t n = 0; n <= last - first; ++n)
+                {
+                    p[std::size_t(n) * stride] = color;
+                }
+            }
+            return last - first + 1;
+        }
+
+        int32_t m = w.moves(first);
+        int32_t err = static_cast<int32_t>(2 * int64_t(w.minor) - w.length +
+                                           2 * int64_t(w.minor) * first - 2 * int64_t(w.length) * m);
+        int32_t a = w.a0 + w.sa * first;
+        int32_t b = w.b0 + w.sb * m;
+        uint32_t written = 0;
+
+        //depth at step j is z0 + (z1 - z0) * j / length rounded, the sum stays within 0..2^32 so unsigned wrap around keeps it exact
+        int32_t const dz = Depth && w.length ? static_cast<int32_t>((int64_t(z1) - z0) * 65536 / w.length) : 0;
+        uint32_t z = (uint32_t(z0) << 16) + 0x8000 + uint32_t(dz) * uint32_t(first);
+
+        for(int32_t j = first; j <= last; ++j)
+        {
+            if(b >= blo && b <= bhi)
+            {
+                int32_t const x = w.x_major ? a : b;
+                int32_t const y = w.x_major ? b : a;
+                if constexpr (Depth)
+                {
+                    uint16_t& d = depth_buffer[std::size_t(y) * xres + x];
+                    if(z >> 16 <= d)
+                    {
+                        d = static_cast<uint16_t>(z >> 16);
+                        pixels[std::size_t(y) * stride + x] = color;
+                        ++written;
+                    }
+                    else
+                    {
+                        ++occluded;
+                    }
+                }
+                else
+                {
+                    pixels[std::size_t(y) * stride + x] = color;
+                    ++written;
+                }
+            }
+            else if(w.sb > 0 ? b > bhi : b < blo)
+            {
+                break;
+            }
+            if(err > 0)
+            {
+                b += w.sb;
+                err -= 2 * w.length;
+            }
+            err += 2 * w.minor;
+            a += w.sa;
+            z += uint32_t(dz);
+        }
+        return written;
+    }
+
+    //per triangle constants of the block loop
+    struct BlockEdges
+    {
+        int64_t lo[3], hi[3];   //from the value at the block origin to the smallest and largest over the block
+#if defined(__SSE2__)
+        __m128i lane[3];        //a * (0, 1, 2, 3), the first 4 pixels of a block row
+        __m128i four[3];        //a * 4, from those to the next 4
+        __m128i row[3];         //b, one row down
+#endif
+    };
+
+    //the covered pixels of t in rows y0..y1, returns how many were written
+    //edge values step from block to block, every block is classified by the range of each edge over it
+    auto raster_triangle(TriangleSetup const & t, int32_t const y0, int32_t const y1) -> uint32_t
+    {
+        int32_t const ylo = std::max(t.ymin, y0);
+        int32_t const yhi = std::min(t.ymax, y1);
+
+        BlockEdges edges;
+        for(uint8_t k = 0; k < 3; ++k)
+        {
+            int64_t const ex = t.a[k] * (BLOCK - 1);
+            int64_t const ey = t.b[k] * (BLOCK - 1);
+            edges.lo[k] = std::min<int64_t>(ex, 0) + std::min<int64_t>(ey, 0);
+            edges.hi[k] = std::max<int64_t>(ex, 0) + std::max<int64_t>(ey, 0);
+#if defined(__SSE2__)
+            //a and b are below 2^25 for any 16 bit viewport
+            int32_t const a = static_cast<int32_t>(t.a[k]);
+            edges.lane[k] = _mm_set_epi32(3 * a, 2 * a, a, 0);
+            edges.four[k] = _mm_set1_epi32(4 * a);
+            edges.row[k] = _mm_set1_epi32(static_cast<int32_t>(t.b[k]));
+#endif
+        }
+
+        uint32_t written = 0;
+        for(int32_t by = ylo & ~(BLOCK - 1); by <= yhi; by += BLOCK)
+        {
+            int32_t const ry0 = std::max(by, ylo);
+            int32_t const ry1 = std::min(by + BLOCK - 1, yhi);
+
+            //consecutive fully covered blocks are filled as one run per row
+            int32_t run0 = 0;
+            int32_t run1 = -1;
+            auto const flush = [&]
+            {
+                for(int32_t y = ry0; run0 <= run1 && y <= ry1; ++y)
+                {
+                    fill16(pixels + std::size_t(y) * stride + run0, run1 - run0 + 1, t.color);
+                }
+                written += std::max(run1 - run0 + 1, 0) * (ry1 - ry0 + 1);
+                run1 = run0 - 1;
+            };
+
+            //columns any row of the block row can cover, each edge bounds them where it is least restrictive
+            int64_t lo = t.xmin;
+            int64_t hi = t.xmax;
+            for(uint8_t k = 0; k < 3; ++k)
+            {
+                int64_t const e = t.b[k] * (t.b[k] > 0 ? ry1 : ry0) + t.c[k];
+                if(t.a[k] > 0)
+                {
+                    lo = std::max(lo, -TriangleSetup::floor_div(e, t.a[k]));
+                }
+                else if(t.a[k] < 0)
+                {
+                    hi = std::min(hi, TriangleSetup::floor_div(e, -t.a[k]));
+                }
+                else if(e < 0)
+                {
+                    hi = lo - 1;
+                }
+            }
+
+            int32_t const bx0 = static_cast<int32_t>(lo) & ~(BLOCK - 1);
+            int64_t e[3] = {t.edge(0, bx0, by), t.edge(1, bx0, by), t.edge(2, bx0, by)};
+            for(int32_t bx = bx0; bx <= hi; bx += BLOCK)
+            {
+                bool outside = false;
+                uint8_t partial = 0;
+                for(uint8_t k = 0; k < 3; ++k)
+                {
+                    outside |= e[k] + edges.hi[k] < 0;
+                    partial |= (e[k] + edges.lo[k] < 0) << k;
+                }
+
+                if(!outside)
+                {
+                    int32_t const cx0 = std::max(bx, t.xmin);
+                    int32_t const cx1 = std::min(bx + BLOCK - 1, t.xmax);
+                    if(!partial)
+                    {
+                        if(run1 != cx0 - 1)
+                        {
+                            flush();
+                            run0 = cx0;
+                        }
+                        run1 = cx1;
+                    }
+                    else
+                    {
+                        written += raster_block(t, edges, e, partial, bx, by, ry0, ry1, cx0, cx1);
+                    }
+                }
+
+                for(uint8_t k = 0; k < 3; ++k)
+                {
+                    e[k] += t.a[k] * BLOCK;
+                }
+            }
+            flush();
+        }
+        return written;
+    }
+
+    //pixels of one block an edge crosses, only the edges in partial are tested
+    //the tested edge values stay within their range over the block, so they fit 32 bits
+    auto raster_block(TriangleSetup const & t, BlockEdges const & edges, int64_t const* e, uint8_t const partial,
+                      int32_t const bx, int32_t const by, int32_t const ry0, int32_t const ry1,
+                      int32_t const cx0, int32_t const cx1) -> uint32_t
+    {
+        uint32_t written = 0;
+#if defined(__SSE2__)
+        if(bx + BLOCK <= xres)
+        {
+            //edges positive over the whole block test as zero, their values may not fit 32 bits
+            __m128i lo[3], hi[3], step[3];
+            for(uint8_t k = 0; k < 3; ++k)
+            {
+                bool const test = partial & (1 << k);
+                lo[k] = test ? _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(e[k] + t.b[k] * (ry0 - by))), edges.lane[k]) : _mm_setzero_si128();
+                hi[k] = test ? _mm_add_epi32(lo[k], edges.four[k]) : _mm_setzero_si128();
+                step[k] = test ? edges.row[k] : _mm_setzero_si128();
+            }
+
+            __m128i const c = _mm_set1_epi16(static_cast<int16_t>(t.color));
+            __m128i const one = _mm_set1_epi16(1);
+            __m128i count = _mm_setzero_si128();
+            for(int32_t y = ry0; y <= ry1; ++y)
+            {
+                //a negative edge value sets the sign bit of the or, which becomes an all ones mask for pixels to keep
+                __m128i const ol = _mm_or_si128(_mm_or_si128(lo[0], lo[1]), lo[2]);
+                __m128i const oh = _mm_or_si128(_mm_or_si128(hi[0], hi[1]), hi[2]);
+                for(uint8_t k = 0; k < 3; ++k)
+                {
+                    lo[k] = _mm_add_epi32(lo[k], step[k]);
+                    hi[k] = _mm_add_epi32(hi[k], step[k]);
+                }
+                __m128i const keep = _mm_packs_epi32(_mm_srai_epi32(ol, 31), _mm_srai_epi32(oh, 31));
+                __m128i* const p = reinterpret_cast<__m128i*>(pixels + std::size_t(y) * stride + bx);
+                __m128i const old = _mm_loadu_si128(p);
+                _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, c)));
+                count = _mm_add_epi16(count, _mm_andnot_si128(keep, one));
+            }
+            count = _mm_madd_epi16(count, one);
+            count = _mm_add_epi32(count, _mm_shuffle_epi32(count, _MM_SHUFFLE(1, 0, 3, 2)));
+            count = _mm_add_epi32(count, _mm_shuffle_epi32(count, _MM_SHUFFLE(2, 3, 0, 1)));
+            written = static_cast<uint32_t>(_mm_cvtsi128_si32(count));
+            return written;
+        }
+#else
+        (void)edges;
+#endif
+        for(int32_t y = ry0; y <= ry1; ++y)
+        {
+            uint16_t* const row = pixels + std::size_t(y) * stride;
+            for(int32_t x = cx0; x <= cx1; ++x)
+            {
+                bool inside = true;
+                for(uint8_t k = 0; k < 3; ++k)
+                {
+                    inside &= !(partial & (1 << k)) || e[k] + t.a[k] * (x - bx) + t.b[k] * (y - by) >= 0;
+                }
+                if(inside)
+                {
+                    row[x] = t.color;
+                    ++written;
+                }
+            }
+        }
+        return written;
+    }
+
+    template<bool Checked>
+    void plot_step(uint16_t* p, int32_t const x, int32_t const y, uint16_t const color)
+    {
+        if constexpr (Checked)
+        {
+            if(uint32_t(x) < xres && uint32_t(y) < yres)
+            {
+                pixels[std::size_t(y) * stride + x] = color;
+                tally(&PipelineStats::pixels, 1);
+            }
+        }
+        else
+        {
+            *p = color;
+        }
+    }
+
+    //bresenham() with the depth of raster_segment<true>, for segments inside the viewport
+    auto bresenham_depth(int32_t const x0, int32_t const y0, uint16_t const z0, int32_t const x1, int32_t const y1, uint16_t const z1,
+                         uint16_t const color, uint64_t& occluded) -> uint32_t
+    {
+        int32_t const dx = std::abs(x1 - x0);
+        int32_t const dy = std::abs(y1 - y0);
+        std::ptrdiff_t const sx = x1 < x0 ? -1 : 1;
+        std::ptrdiff_t const sy = y1 < y0 ? -1 : 1;
+        bool const x_major = dx >= dy;
+        int32_t const length = x_major ? dx : dy;
+        int32_t const minor = x_major ? dy : dx;
+
+        //steps along the major and minor axis, for the color and the depth buffer
+        std::ptrdiff_t const pa = x_major ? sx : sy * std::ptrdiff_t(stride);
+        std::ptrdiff_t const pb = x_major ? sy * std::ptrdiff_t(stride) : sx;
+        std::ptrdiff_t const qa = x_major ? sx : sy * std::ptrdiff_t(xres);
+        std::ptrdiff_t const qb = x_major ? sy * std::ptrdiff_t(xres) : sx;
+        uint16_t* p = pixels + std::ptrdiff_t(y0) * std::ptrdiff_t(stride) + x0;
+        uint16_t* q = depth_buffer.data() + std::ptrdiff_t(y0) * xres + x0;
+
+        int32_t const dz = length ? static_cast<int32_t>((int64_t(z1) - z0) * 65536 / length) : 0;
+        uint32_t z = (uint32_t(z0) << 16) + 0x8000;
+        uint32_t written = 0;
+        int32_t err = 2 * minor - length;
+        for(int32_t n = length; n >= 0; --n)
+        {
+            uint16_t const d = static_cast<uint16_t>(z >> 16);
+            bool const pass = d <= *q;
+            *q = pass ? d : *q;
+            *p = pass ? color : *p;
+            written += pass;
+            if(err > 0)
+            {
+                p += pb;
+                q += qb;
+                err -= 2 * length;
+            }
+            err += 2 * minor;
+            p += pa;
+            q += qa;
+            z += uint32_t(dz);
+        }
+        occluded += length + 1 - written;
+        return written;
+    }
+
+    //walks the major axis with pointer steps, Checked rejects pixels outside the viewport
+    template<bool Checked>
+    void bresenham(int32_t x0, int32_t y0, int32_t const x1, int32_t const y1, uint16_t const color)
+    {
+        int32_t dx = x1 - x0;
+        int32_t dy = y1 - y0;
+        int32_t const sx = dx < 0 ? -1 : 1;
+        int32_t const sy = dy < 0 ? -1 : 1;
+        dx = std::abs(dx);
+        dy = std::abs(dy);
+
+        //the checked walk may leave the buffer, so it addresses pixels from x0/y0 instead of p
+        std::ptrdiff_t const stepx = Checked ? 0 : sx;
+        std::ptrdiff_t const stepy = Checked ? 0 : sy * std::ptrdiff_t(stride);
+        uint16_t* p = Checked ? pixels : pixels + std::ptrdiff_t(y0) * std::ptrdiff_t(stride) + x0;
+
+        if(dx >= dy)
+        {
+            int32_t err = 2 * dy - dx;
+            for(int32_t n = dx; n >= 0; --n)
+            {
+                plot_step<Checked>(p, x0, y0, color);
+                if(err > 0)
+                {
+                    p += stepy;
+                    y0 += sy;
+                    err -= 2 * dx;
+                }
+                err += 2 * dy;
+                p += stepx;
+                x0 += sx;
+            }
+        }
+        else
+        {
+            int32_t err = 2 * dx - dy;
+            for(int32_t n = dy; n >= 0; --n)
+            {
+                plot_step<Checked>(p, x0, y0, color);
+                if(err > 0)
+                {
+                    p += stepx;
+                    x0 += sx;
+                    err -= 2 * dy;
+                }
+                err += 2 * dx;
+                p += stepy;
+                y0 += sy;
+            }
+        }
+    }
+};
+
+}
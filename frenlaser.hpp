@@ -0,0 +1,465 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <vector>
+
+#include "fren.hpp"
+
+namespace fren
+{
+
+//what the path optimizer did with the last presented frame, lengths are in ilda units
+//galvo axes move independently, so a move costs max(|dx|, |dy|)
+struct LaserFrameStats
+{
+    uint32_t segments = 0;
+    uint32_t chains = 0;            //runs of connected segments drawn without blanking
+    uint32_t points = 0;            //records written
+    uint32_t frames = 0;            //ilda frames written, more than one when the records do not fit in one
+    uint32_t blank_points = 0;
+    uint64_t blank_travel = 0;      //after reordering and flipping
+    uint64_t draw_order_travel = 0; //the same chains in draw order, for comparison
+};
+
+//laser backend, writes every presented frame as an ilda format 5 (2d true color) frame
+//segments are collected between clear() and present(), joined into chains where they connect,
+//then reordered and flipped (nearest neighbour, then 2-opt) to shorten the blanked travel between chains
+//a present of more than 65535 records continues in as many further ilda frames as it needs
+class LaserContext : public Context
+{
+public:
+
+    ~LaserContext() override
+    {
+        setAsync(false);
+    }
+
+    //ilda stream to write to, finish() terminates it
+    //the setters wait for the raster thread in async mode
+    void setOutput(std::ostream* os)
+    {
+        Finish();
+        output = os;
+    }
+
+    //largest step between two points, lit lines and blanked moves are subdivided to it
+    void setPointSpacing(uint16_t const lit, uint16_t const blank)
+    {
+        Finish();
+        lit_step = std::max<uint16_t>(lit, 1);
+        blank_step = std::max<uint16_t>(blank, 1);
+    }
+
+    //extra points held where the beam turns on or off so the galvos settle
+    void setDwell(uint8_t const points)
+    {
+        Finish();
+        dwell = points;
+    }
+
+    //2-opt is quadratic per pass, above this many chains only nearest neighbour runs
+    void setTwoOptLimit(uint32_t const chains)
+    {
+        Finish();
+        two_opt_limit = chains;
+    }
+
+    //nearest neighbour is quadratic too, above this many chains they are drawn in submission order
+    void setNearestLimit(uint32_t const chains)
+    {
+        Finish();
+        nearest_limit = chains;
+    }
+
+    auto frameStats() const -> LaserFrameStats const&
+    {
+        return stats;
+    }
+
+    void clear() override
+    {
+        path.clear();
+        colors.clear();
+        chains.clear();
+    }
+
+    void present() override
+    {
+        build_route();
+        emit_frame();
+        clear();
+    }
+
+    //writes the empty frame that ends an ilda file
+    void finish()
+    {
+        Finish();
+        if(output)
+        {
+            write_header(0);
+            output->flush();
+        }
+    }
+
+    void line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) override
+    {
+        add_segment(to_ilda(int64_t(x1) << 16, int64_t(y1) << 16),
+                    to_ilda(int64_t(x2) << 16, int64_t(y2) << 16), color);
+    }
+
+    void plot(uint16_t x, uint16_t y, uint16_t color) override
+    {
+        line(x, y, x, y, color);
+    }
+
+    //collects the window space segments instead of drawing them, keeping the subpixel position
+    void lines(VertexStream const & in, uint32_t const first, uint32_t const n) override
+    {
+        for(uint32_t i = first; i + 1 < first + n; i = i + 2)
+        {
+            add_segment(to_ilda(in.x[i], in.y[i]), to_ilda(in.x[i+1], in.y[i+1]), in.col[i]);
+        }
+    }
+
+    //each point as a chain of its own, at its subpixel position
+    void points(VertexStream const & in, uint32_t const first, uint32_t const n) override
+    {
+        for(uint32_t i = first; i < first + n; ++i)
+        {
+            LaserPoint const p = to_ilda(in.x[i], in.y[i]);
+            add_segment(p, p, in.col[i]);
+        }
+    }
+
+protected:
+
+    struct LaserPoint
+    {
+        int16_t x, y;
+
+        auto operator==(LaserPoint const &) const -> bool = default;
+    };
+
+    //a chain is path[first, first + count), colors[i] is the color of the segment leaving path[i]
+    //a single point chain keeps its own color in colors[first]
+    struct Chain
+    {
+        uint32_t first, count;
+    };
+
+    //a chain in route order, reversed chains are drawn from their last point
+    struct Route
+    {
+        uint32_t chain;
+        bool reversed;
+    };
+
+    std::ostream* output = nullptr;
+    uint16_t lit_step = 1024;
+    uint16_t blank_step = 4096;
+    uint8_t dwell = 3;
+    uint32_t two_opt_limit = 256;
+    uint32_t nearest_limit = 2048;
+    uint16_t frame_number = 0;
+
+    std::vector<LaserPoint> path;
+    std::vector<uint16_t> colors;
+    std::vector<Chain> chains;
+    std::vector<Route> route;
+    std::vector<uint8_t> visited;
+    std::vector<uint8_t> records;
+
+    //where the galvos stopped at the end of the last frame
+    LaserPoint beam{0, 0};
+    LaserFrameStats stats;
+
+    //window space 16.16, y down, to the signed ilda range, y up
+    auto to_ilda(int64_t const x, int64_t const y) const -> LaserPoint
+    {
+        int64_t const sx = std::max<int64_t>(xres, 1) << 16;
+        int64_t const sy = std::max<int64_t>(yres, 1) << 16;
+        int64_t const ix = x * 65535 / sx - 32768;
+        int64_t const iy = 32767 - y * 65535 / sy;
+        return {static_cast<int16_t>(std::clamp<int64_t>(ix, INT16_MIN, INT16_MAX)),
+                static_cast<int16_t>(std::clamp<int64_t>(iy, INT16_MIN, INT16_MAX))};
+    }
+
+    //segments that start where the previous one ended extend its chain
+    void add_segment(LaserPoint const a, LaserPoint const b, uint16_t const color)
+    {
+        if(!chains.empty() && chains.back().count > 1 && path.back() == a && !(a == b))
+        {
+            colors.back() = color;
+            path.push_back(b);
+            colors.push_back(color);
+            ++chains.back().count;
+            return;
+        }
+
+        chains.push_back({uint32_t(path.size()), a == b ? 1u : 2u});
+        path.push_back(a);
+        colors.push_back(color);
+        if(!(a == b))
+        {
+            path.push_back(b);
+            colors.push_back(color);
+        }
+    }
+
+    static auto travel(LaserPoint const a, LaserPoint const b) -> uint32_t
+    {
+        return std::max(std::abs(int32_t(a.x) - b.x), std::abs(int32_t(a.y) - b.y));
+    }
+
+    auto entry(Route const r) const -> LaserPoint
+    {
+        Chain const & c = chains[r.chain];
+        return path[r.reversed ? c.first + c.count - 1 : c.first];
+    }
+
+    auto exit(Route const r) const -> LaserPoint
+    {
+        Chain const & c = chains[r.chain];
+        return path[r.reversed ? c.first : c.first + c.count - 1];
+    }
+
+    auto route_travel() const -> uint64_t
+    {
+        uint64_t total = 0;
+        LaserPoint at = beam;
+        for(Route const r : route)
+        {
+            total += travel(at, entry(r));
+            at = exit(r);
+        }
+        return total;
+    }
+
+    void build_route()
+    {
+        uint32_t const n = chains.size();
+        stats = {};
+        stats.chains = n;
+        stats.segments = path.size() - n;
+        for(Chain const & c : chains)
+        {
+            stats.segments += c.count == 1;
+        }
+
+        route.resize(n);
+        for(uint32_t i = 0; i < n; ++i)
+        {
+            route[i] = {i, false};
+        }
+        stats.draw_order_travel = route_travel();
+        if(n > nearest_limit)
+        {
+            stats.blank_travel = stats.draw_order_travel;
+            return;
+        }
+
+        //greedy nearest neighbour from the beam position, either end of a chain may be entered
+        visited.assign(n, 0);
+        LaserPoint at = beam;
+        for(uint32_t k = 0; k < n; ++k)
+        {
+            Route best{0, false};
+            uint32_t best_cost = UINT32_MAX;
+            for(uint32_t i = 0; i < n && best_cost; ++i)
+            {
+                if(visited[i])
+                {
+                    continue;
+                }
+                uint32_t const forward = travel(at, entry({i, false}));
+                uint32_t const backward = travel(at, entry({i, true}));
+                if(forward < best_cost)
+                {
+                    best = {i, false};
+                    best_cost = forward;
+                }
+                if(backward < best_cost)
+                {
+                    best = {i, true};
+                    best_cost = backward;
+                }
+            }
+            visited[best.chain] = 1;
+            route[k] = best;
+            at = exit(best);
+        }
+
+        //greedy can lose to the order the geometry was drawn in, keep the shorter one
+        if(route_travel() > stats.draw_order_travel)
+        {
+            for(uint32_t i = 0; i < n; ++i)
+            {
+                route[i] = {i, false};
+            }
+        }
+
+        if(n <= two_opt_limit)
+        {
+            two_opt();
+        }
+
+        stats.blank_travel = route_travel();
+    }
+
+    //reversing route[i..j] also flips every chain in it, only the two edges around the range change
+    void two_opt()
+    {
+        uint32_t const n = route.size();
+        for(uint32_t pass = 0; pass < 16; ++pass)
+        {
+            bool improved = false;
+            for(uint32_t i = 0; i < n; ++i)
+            {
+                LaserPoint const before = i ? exit(route[i-1]) : beam;
+                for(uint32_t j = i + 1; j < n; ++j)
+                {
+                    LaserPoint const in_i = entry(route[i]);
+                    LaserPoint const out_j = exit(route[j]);
+                    int64_t delta = int64_t(travel(before, out_j)) - travel(before, in_i);
+                    if(j + 1 < n)
+                    {
+                        LaserPoint const after = entry(route[j+1]);
+                        delta += int64_t(travel(in_i, after)) - travel(out_j, after);
+                    }
+                    if(delta < 0)
+                    {
+                        std::reverse(route.begin() + i, route.begin() + j + 1);
+                        for(uint32_t k = i; k <= j; ++k)
+                        {
+                            route[k].reversed = !route[k].reversed;
+                        }
+                        improved = true;
+                    }
+                }
+            }
+            if(!improved)
+            {
+                break;
+            }
+        }
+    }
+
+    void emit_frame()
+    {
+        records.clear();
+        LaserPoint at = beam;
+
+        for(Route const r : route)
+        {
+            Chain const & c = chains[r.chain];
+            LaserPoint const start = entry(r);
+
+            if(!(start == at) || records.empty())
+            {
+                //blank from the last point, hold there, then light up at the chain start
+                if(!records.empty())
+                {
+                    emit_run(at, 0, dwell);
+                }
+                emit_move(at, start, 0, blank_step);
+                emit_run(start, 0, dwell);
+                emit_run(start, colors[r.reversed ? c.first + c.count - 1 : c.first], dwell);
+            }
+
+            if(c.count == 1)
+            {
+                emit_run(start, colors[c.first], 1);
+            }
+            for(uint32_t k = 1; k < c.count; ++k)
+            {
+                //walking a reversed chain, the segment into point p is the one leaving it forward
+                uint32_t const p = r.reversed ? c.first + c.count - 1 - k : c.first + k;
+                uint16_t const color = r.reversed ? colors[p] : colors[p - 1];
+                emit_move(path[r.reversed ? p + 1 : p - 1], path[p], color, lit_step);
+            }
+            at = exit(r);
+        }
+
+        if(records.empty())
+        {
+            emit_run(at, 0, 1);
+        }
+        else
+        {
+            emit_run(at, 0, dwell);
+        }
+
+        //ilda frames hold at most 65535 records, the rest goes on in the frames after, each with its last point flagged
+        uint32_t const total = records.size() / 8;
+        stats.points = total;
+        beam = at;
+        for(uint32_t first = 0; first < total; first += UINT16_MAX)
+        {
+            uint16_t const count = static_cast<uint16_t>(std::min<uint32_t>(total - first, UINT16_MAX));
+            records[(first + count - 1) * 8 + 4] |= 0x80;
+            if(output)
+            {
+                write_header(count);
+                output->write(reinterpret_cast<char const*>(records.data() + std::size_t(first) * 8), std::streamsize(count) * 8);
+            }
+            ++stats.frames;
+            ++frame_number;
+        }
+    }
+
+    //points from a (excluded) to b (included) no further than step apart, color 0 is blanked
+    void emit_move(LaserPoint const a, LaserPoint const b, uint16_t const color, uint16_t const step)
+    {
+        int32_t const steps = std::max<int32_t>(1, (travel(a, b) + step - 1) / step);
+        for(int32_t s = 1; s <= steps; ++s)
+        {
+            emit_point({static_cast<int16_t>(a.x + (int32_t(b.x) - a.x) * s / steps),
+                        static_cast<int16_t>(a.y + (int32_t(b.y) - a.y) * s / steps)}, color);
+        }
+    }
+
+    void emit_run(LaserPoint const p, uint16_t const color, uint32_t const count)
+    {
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            emit_point(p, color);
+        }
+    }
+
+    //format 5 record, x y big endian, status, b g r
+    void emit_point(LaserPoint const p, uint16_t const color)
+    {
+        std::array<uint8_t, 4> const rgb = Convert555to888(color);
+        bool const blank = color == 0;
+        stats.blank_points += blank;
+        uint8_t const record[8] =
+        {
+            uint8_t(uint16_t(p.x) >> 8), uint8_t(p.x),
+            uint8_t(uint16_t(p.y) >> 8), uint8_t(p.y),
+            uint8_t(blank ? 0x40 : 0x00),
+            rgb[2], rgb[1], rgb[0]
+        };
+        records.insert(records.end(), record, record + 8);
+    }
+
+    void write_header(uint16_t const count)
+    {
+        uint8_t const header[32] =
+        {
+            'I', 'L', 'D', 'A', 0, 0, 0, 5,
+            'f', 'r', 'e', 'n', ' ', ' ', ' ', ' ',
+            'f', 'v', 'e', 'c', ' ', ' ', ' ', ' ',
+            uint8_t(count >> 8), uint8_t(count),
+            uint8_t(frame_number >> 8), uint8_t(frame_number),
+            0, 0,   //total frames, unknown while streaming
+            0, 0
+        };
+        output->write(reinterpret_cast<char const*>(header), sizeof(header));
+    }
+};
+
+}
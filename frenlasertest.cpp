@@ -0,0 +1,180 @@
+#include "frenlaser.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//the ilda stream of LaserContext read back with a parser of its own
+//headers, record counts and last point flags, a present too large for one ilda frame, and the travel of the reordered path
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+using fren::math::vec3;
+
+int failures = 0;
+
+void check(char const* name, bool const ok)
+{
+    std::printf("%-44s %s\n", name, ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+struct IldaFrame
+{
+    bool magic;
+    uint8_t format;
+    uint16_t count;
+    uint16_t number;
+    std::string records;    //count records of 8 bytes
+};
+
+//every frame of the stream up to and including the empty one that ends it
+auto parse(std::string const & s) -> std::vector<IldaFrame>
+{
+    std::vector<IldaFrame> frames;
+    std::size_t o = 0;
+    while(o + 32 <= s.size())
+    {
+        IldaFrame f;
+        f.magic = s.compare(o, 4, "ILDA") == 0;
+        f.format = static_cast<uint8_t>(s[o + 7]);
+        f.count = static_cast<uint16_t>((uint8_t(s[o + 24]) << 8) | uint8_t(s[o + 25]));
+        f.number = static_cast<uint16_t>((uint8_t(s[o + 26]) << 8) | uint8_t(s[o + 27]));
+        o += 32;
+        f.records = s.substr(o, std::size_t(f.count) * 8);
+        o += std::size_t(f.count) * 8;
+        frames.push_back(f);
+        if(f.count == 0)
+        {
+            break;
+        }
+    }
+    return frames;
+}
+
+//status byte of record i, 0x80 marks the last point of a frame and 0x40 a blanked point
+auto status(IldaFrame const & f, uint32_t const i) -> uint8_t
+{
+    return static_cast<uint8_t>(f.records[std::size_t(i) * 8 + 4]);
+}
+
+//exactly the last record of a frame carries the last point flag
+auto last_flag_only_at_end(IldaFrame const & f) -> bool
+{
+    for(uint32_t i = 0; i < f.count; ++i)
+    {
+        if(bool(status(f, i) & 0x80) != (i + 1 == f.count))
+        {
+            return false;
+        }
+    }
+    return f.count > 0;
+}
+
+auto well_formed(std::vector<IldaFrame> const & frames, std::size_t const from, std::size_t const to) -> bool
+{
+    bool ok = to <= frames.size();
+    for(std::size_t i = from; ok && i < to; ++i)
+    {
+        ok = frames[i].magic && frames[i].format == 5 && frames[i].number == i && frames[i].records.size() == std::size_t(frames[i].count) * 8
+          && last_flag_only_at_end(frames[i]);
+    }
+    return ok;
+}
+
+vec3 cube[8] =
+{
+    {{-0.5_fx, -0.5_fx}, -0.5_fx}, {{0.5_fx, -0.5_fx}, -0.5_fx}, {{0.5_fx, 0.5_fx}, -0.5_fx}, {{-0.5_fx, 0.5_fx}, -0.5_fx},
+    {{-0.5_fx, -0.5_fx}, 0.5_fx}, {{0.5_fx, -0.5_fx}, 0.5_fx}, {{0.5_fx, 0.5_fx}, 0.5_fx}, {{-0.5_fx, 0.5_fx}, 0.5_fx}
+};
+uint8_t edges[24] = {0, 1, 1, 2, 2, 3, 3, 0, 4, 5, 5, 6, 6, 7, 7, 4, 0, 4, 1, 5, 2, 6, 3, 7};
+
+}
+
+auto main() -> int
+{
+    std::ostringstream os;
+    fren::LaserContext ctx;
+    fren::MatrixVertexFunction camera;
+    ctx.setViewPort(640, 480);
+    ctx.setOutput(&os);
+    ctx.setVertexFunction(&camera);
+
+    //a grid of rotated cubes, the chains of each cube land all over the frame in draw order
+    bool travel = true;
+    bool one_frame = true;
+    std::vector<uint32_t> points;
+    ctx.VertexPointer(3, cube);
+    ctx.IndexPointer(edges);
+    for(uint32_t f = 0; f < 3; ++f)
+    {
+        ctx.clear();
+        for(int32_t gy = 0; gy < 4; ++gy)
+        {
+            for(int32_t gx = 0; gx < 4; ++gx)
+            {
+                camera.mvp = fren::math::perspective(1.0_fx, 1.33_fx, 0.5_fx, 100.0_fx)
+                           * fren::math::translate({{fixed32(1.5f * (gx - 1.5f)), fixed32(1.5f * (gy - 1.5f))}, -8.0_fx})
+                           * fren::math::rotate(fixed32(0.3f + f * 0.1f + gx * 0.2f), {{0.577_fx, 0.577_fx}, 0.577_fx});
+                ctx.DrawElements(f == 2 ? fren::DrawType::Line_Strip : fren::DrawType::Lines, 24);
+            }
+        }
+        ctx.present();
+        fren::LaserFrameStats const & s = ctx.frameStats();
+        travel = travel && s.chains > 1 && s.blank_travel <= s.draw_order_travel;
+        one_frame = one_frame && s.frames == 1;
+        points.push_back(s.points);
+    }
+
+    //random segments, far more chains than the cubes
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+    std::vector<vec2> soup(2000);
+    for(vec2& p : soup)
+    {
+        p = {fixed32(d(rng)), fixed32(d(rng))};
+    }
+    camera.mvp = fren::math::identity();
+    ctx.VertexPointer(2, soup.data());
+    ctx.clear();
+    ctx.DrawArray(fren::DrawType::Lines, 0, soup.size());
+    ctx.present();
+    travel = travel && ctx.frameStats().chains > 1 && ctx.frameStats().blank_travel <= ctx.frameStats().draw_order_travel;
+    one_frame = one_frame && ctx.frameStats().frames == 1;
+    points.push_back(ctx.frameStats().points);
+
+    //two lines across the view lit every ilda unit, about 118000 records that continue in a second frame
+    vec2 across[4] = {{-0.9_fx, 0.5_fx}, {0.9_fx, 0.5_fx}, {-0.9_fx, -0.5_fx}, {0.9_fx, -0.5_fx}};
+    ctx.setPointSpacing(1, 64);
+    ctx.VertexPointer(2, across);
+    ctx.clear();
+    ctx.DrawArray(fren::DrawType::Lines, 0, 4);
+    ctx.present();
+    uint32_t const long_points = ctx.frameStats().points;
+    uint32_t const long_frames = ctx.frameStats().frames;
+    ctx.finish();
+
+    std::vector<IldaFrame> const frames = parse(os.str());
+    std::printf("%zu ilda frames, %u records in the long present\n", frames.size(), long_points);
+
+    check("reordered travel within draw order travel", travel);
+    check("small presents in one ilda frame", one_frame);
+    check("headers, counts and last point flags", frames.size() == 7 && well_formed(frames, 0, 6));
+    bool counts = frames.size() == 7;
+    for(std::size_t i = 0; counts && i < points.size(); ++i)
+    {
+        counts = frames[i].count == points[i];
+    }
+    check("records match frameStats", counts);
+    check("long present continues in a second frame", long_frames == 2 && long_points > UINT16_MAX && long_points <= 2u * UINT16_MAX
+        && frames.size() == 7 && frames[4].count == UINT16_MAX && frames[5].count == long_points - UINT16_MAX);
+    check("stream ends in an empty frame", frames.size() == 7 && frames[6].magic && frames[6].count == 0
+        && os.str().size() == frames.size() * 32 + std::size_t(points[0] + points[1] + points[2] + points[3] + long_points) * 8);
+    return failures ? 1 : 0;
+}
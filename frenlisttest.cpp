@@ -0,0 +1,147 @@
+#include "frenfb.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+//display list replays against the same draws made immediately, and cached replays against the one that cached them
+//needs FREN_PIPELINE_STATS for the counters
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+using fren::math::vec3;
+
+int failures = 0;
+
+void check(char const* name, bool const ok)
+{
+    std::printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+auto same_pixels(fren::FramebufferContext const & a, fren::FramebufferContext const & b) -> bool
+{
+    for(uint16_t y = 0; y < a.height(); ++y)
+    {
+        for(uint16_t x = 0; x < a.width(); ++x)
+        {
+            if(a.pixel(x, y) != b.pixel(x, y))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto lit_pixels(fren::FramebufferContext const & a) -> uint32_t
+{
+    uint32_t lit = 0;
+    for(uint16_t y = 0; y < a.height(); ++y)
+    {
+        for(uint16_t x = 0; x < a.width(); ++x)
+        {
+            lit += a.pixel(x, y) != 0 ? 1 : 0;
+        }
+    }
+    return lit;
+}
+
+//a square outline, as line pairs
+std::vector<vec2> const square =
+{
+    {-0.5_fx, -0.5_fx}, {0.5_fx, -0.5_fx},
+    {0.5_fx, -0.5_fx}, {0.5_fx, 0.5_fx},
+    {0.5_fx, 0.5_fx}, {-0.5_fx, 0.5_fx},
+    {-0.5_fx, 0.5_fx}, {-0.5_fx, -0.5_fx},
+};
+
+//bounds set while recording without a vertex function, the list keeps the draw under an identity matrix
+void test_bounds_without_vertex_function()
+{
+    fren::FramebufferContext immediate;
+    fren::MatrixVertexFunction identity;
+    immediate.setViewPort(64, 48);
+    immediate.setVertexFunction(&identity);
+    immediate.ColorPointer(nullptr);
+    immediate.VertexPointer(2, const_cast<vec2*>(square.data()));
+    immediate.clear();
+    immediate.DrawArray(fren::DrawType::Lines, 0, square.size());
+
+    fren::FramebufferContext replayed;
+    fren::DisplayList list;
+    replayed.setViewPort(64, 48);
+    replayed.ColorPointer(nullptr);
+    replayed.VertexPointer(2, const_cast<vec2*>(square.data()));
+    replayed.setBounds(fren::Bounds::of(std::span<const vec2>(square)));
+    replayed.NewList(list);
+    replayed.DrawArray(fren::DrawType::Lines, 0, square.size());
+    replayed.EndList();
+    replayed.clear();
+    replayed.CallList(list);
+
+    check("bounds without vertex function", lit_pixels(immediate) > 0 && same_pixels(immediate, replayed));
+}
+
+
+auto same_stats(fren::PipelineStats const & a, fren::PipelineStats const & b) -> bool
+{
+    return a.draws == b.draws && a.vertices == b.vertices && a.shaded == b.shaded && a.primitives == b.primitives &&
+           a.accepted == b.accepted && a.clipped == b.clipped && a.rejected == b.rejected && a.discarded == b.discarded &&
+           a.points == b.points && a.segments == b.segments && a.triangles == b.triangles && a.pixels == b.pixels;
+}
+
+//the second CallList draws from the window space cache and has to count what the first one did
+void test_cached_replay_stats()
+{
+    //segments inside, crossing and outside the view volume, triangles of both windings and points
+    std::vector<vec3> verts =
+    {
+        {{-0.5_fx, -0.5_fx}, 0.0_fx}, {{0.5_fx, 0.5_fx}, 0.0_fx},
+        {{-2.0_fx, 0.1_fx}, 0.0_fx}, {{2.0_fx, 0.2_fx}, 0.0_fx},
+        {{1.5_fx, 1.5_fx}, 0.0_fx}, {{1.8_fx, 1.2_fx}, 0.0_fx},
+        {{-0.9_fx, -0.9_fx}, 0.0_fx}, {{-0.1_fx, -0.9_fx}, 0.0_fx}, {{-0.5_fx, -0.1_fx}, 0.0_fx},
+        {{0.1_fx, 0.1_fx}, 0.0_fx}, {{0.5_fx, 0.9_fx}, 0.0_fx}, {{0.9_fx, 0.1_fx}, 0.0_fx},
+        {{0.3_fx, -0.6_fx}, 0.0_fx}, {{3.0_fx, -0.6_fx}, 0.0_fx},
+    };
+
+    fren::FramebufferContext ctx;
+    fren::MatrixVertexFunction identity;
+    fren::DisplayList list;
+    ctx.setViewPort(64, 48);
+    ctx.setVertexFunction(&identity);
+    ctx.ColorPointer(nullptr);
+    ctx.VertexPointer(3, verts.data());
+    ctx.setCullFace(fren::CullFace::Back);
+    ctx.NewList(list);
+    ctx.DrawArray(fren::DrawType::Lines, 0, 6);
+    ctx.DrawArray(fren::DrawType::Triangles, 6, 6);
+    ctx.DrawArray(fren::DrawType::Points, 12, 2);
+    ctx.EndList();
+
+    ctx.clear();
+    ctx.resetPipelineStats();
+    ctx.CallList(list);
+    fren::PipelineStats const first = ctx.pipelineStats();
+
+    ctx.clear();
+    ctx.resetPipelineStats();
+    ctx.CallList(list);
+    fren::PipelineStats const cached = ctx.pipelineStats();
+
+    bool const counted = first.shaded > 0 && first.accepted > 0 && first.clipped > 0 && first.rejected > 0 && first.discarded > 0;
+    check("cached replay counts like the first", counted && same_stats(first, cached));
+}
+
+}
+
+auto main() -> int
+{
+    test_bounds_without_vertex_function();
+    test_cached_replay_stats();
+    return failures ? 1 : 0;
+}
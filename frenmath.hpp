@@ -2,7 +2,19 @@
 
 #include <cmath>
 #include <cstdint>
+#include <climits>
 #include <numbers>
+#include <array>
+#include <span>
+#include <bit>
+#include <concepts>
+#include <type_traits>
+
+#if defined(__AVX__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace fren::math
 {
@@ -105,163 +117,567 @@ public:
 
 };
 
+template<class T, std::size_t S, auto FUNC>
+constexpr auto makeTable() -> std::array<T, S>
+{
+    std::array<T,S> r{};
+    for(std::size_t i = 0; i < S; ++i)
+    {
+        r[i] = FUNC(i);
+    }
+    return r;
+}
+
+constexpr auto fromRaw(int32_t const raw) -> fixed32
+{
+    fixed32 r;
+    r.data = raw;
+    return r;
+}
+
+//integer only kernels, no float at runtime and usable in constant expressions
+//accuracy against double over the 16.16 input range, frenmathtest.cpp sweeps it and checks these bounds:
+//  sqrt        exact, floor of the true root
+//  rsqrt       within 0.51 lsb
+//  reciprocal  quotients within 1 lsb while |n| <= |d|, beyond that half an lsb plus 2^-29 relative
+//  sin/cos     within 2 lsb (3e-5)
+//  atan2       within 2.5 lsb, the table gives up to 1.5 and the rounded pi and pi/2 the rest
+namespace detail
+{
+
+//floor(sqrt(n)), one result bit per iteration
+constexpr auto isqrt(uint64_t n) -> uint64_t
+{
+    uint64_t r = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while(bit > n)
+    {
+        bit >>= 2;
+    }
+    while(bit)
+    {
+        if(n >= r + bit)
+        {
+            n -= r + bit;
+            r = (r >> 1) + bit;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+//table generators, only ever run by the compiler
+constexpr double gen_pi = 3.14159265358979323846;
+
+constexpr auto gen_sqrt(double const x) -> double
+{
+    double r = x > 1.0 ? x : 1.0;
+    for(int i = 0; i < 64; ++i)
+    {
+        r = 0.5 * (r + x / r);
+    }
+    return r;
+}
+
+constexpr auto gen_sin(double const x) -> double
+{
+    double term = x;
+    double sum = x;
+    for(int n = 1; n < 16; ++n)
+    {
+        term *= -x * x / double((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+//atan(x) = 2 atan(x / (1 + sqrt(1 + x^2))) keeps the series argument below 0.42
+constexpr auto gen_atan(double const x) -> double
+{
+    double const y = x / (1.0 + gen_sqrt(1.0 + x * x));
+    double term = y;
+    double sum = y;
+    for(int n = 1; n < 40; ++n)
+    {
+        term *= -y * y;
+        sum += term / double(2 * n + 1);
+    }
+    return 2.0 * sum;
+}
+
+constexpr auto gen_round(double const x) -> int32_t
+{
+    return static_cast<int32_t>(x < 0.0 ? x * 65536.0 - 0.5 : x * 65536.0 + 0.5);
+}
+
+constexpr std::size_t TRIG_BITS = 8;                    //segments per quarter wave, log2
+constexpr std::size_t TRIG_SEGMENTS = 1 << TRIG_BITS;
+
+constexpr auto sin_entry(std::size_t const i) -> int32_t
+{
+    return gen_round(gen_sin(gen_pi / 2.0 * double(i) / double(TRIG_SEGMENTS)));
+}
+
+constexpr auto atan_entry(std::size_t const i) -> int32_t
+{
+    return gen_round(gen_atan(double(i) / double(TRIG_SEGMENTS)));
+}
+
+//rsqrt seeds, 1/sqrt(u) in 2.30 for u at the middle of [i/16, (i+1)/16)
+constexpr auto rsqrt_entry(std::size_t const i) -> uint32_t
+{
+    return i < 4 ? 0 : static_cast<uint32_t>(1073741824.0 / gen_sqrt((double(i) + 0.5) / 16.0));
+}
+
+//reciprocal seeds, 1/u in 2.30 for u at the middle of [0.5 + i/256, 0.5 + (i+1)/256)
+constexpr auto recip_entry(std::size_t const i) -> uint32_t
+{
+    return static_cast<uint32_t>(1073741824.0 / (0.5 + (double(i) + 0.5) / 256.0));
+}
+
+//one extra entry so interpolation never reads past the end
+constexpr auto sin_table = makeTable<int32_t, TRIG_SEGMENTS + 1, sin_entry>();
+constexpr auto atan_table = makeTable<int32_t, TRIG_SEGMENTS + 1, atan_entry>();
+constexpr auto rsqrt_table = makeTable<uint32_t, 16, rsqrt_entry>();
+constexpr auto recip_table = makeTable<uint32_t, 128, recip_entry>();
+
+//interpolated lookup, pos is 8.16 in table segments
+constexpr auto lerp_table(std::array<int32_t, TRIG_SEGMENTS + 1> const & t, uint32_t const pos) -> int32_t
+{
+    uint32_t const i = pos >> 16;
+    int32_t const f = pos & 0xFFFF;
+    if(i >= TRIG_SEGMENTS)
+    {
+        return t[TRIG_SEGMENTS];
+    }
+    return t[i] + static_cast<int32_t>((int64_t(t[i + 1] - t[i]) * f) >> 16);
+}
+
+//phase of a 16.16 angle in 16.16 quarter wave segments, 2^24 per quadrant
+//1024 / 2pi in 8.24
+constexpr int64_t RAD_TO_SEGMENTS = 2734261102;
+
+constexpr auto sin_phase(int64_t phase) -> int32_t
+{
+    constexpr int64_t quarter = int64_t(1) << 24;
+    phase &= (quarter << 2) - 1;
+    uint32_t const quadrant = static_cast<uint32_t>(phase >> 24);
+    uint32_t const pos = static_cast<uint32_t>(phase & (quarter - 1));
+    int32_t const v = lerp_table(sin_table, (quadrant & 1) ? static_cast<uint32_t>(quarter) - pos : pos);
+    return (quadrant & 2) ? -v : v;
+}
+
+//y = 1/sqrt(u) in 2.30 for u = m / 2^32 in [0.25, 1), seeded from the table then newton
+constexpr auto rsqrt_unit(uint32_t const m) -> uint64_t
+{
+    uint64_t y = rsqrt_table[m >> 28];
+    for(int i = 0; i < 3; ++i)
+    {
+        uint64_t const y2 = (y * y) >> 30;
+        uint64_t const t = (m * y2) >> 32;
+        y = (y * ((uint64_t(3) << 30) - t)) >> 31;
+    }
+    return y;
+}
+
+//y = 1/u in 2.30 for u = m / 2^32 in [0.5, 1), seeded from the table then two newton steps
+constexpr auto recip_unit(uint32_t const m) -> uint64_t
+{
+    uint64_t y = recip_table[(m >> 24) & 127];
+    for(int i = 0; i < 2; ++i)
+    {
+        uint64_t const t = (m * y) >> 30;
+        y = (y * ((uint64_t(1) << 33) - t)) >> 32;
+    }
+    return y;
+}
+
+//splits 1/sqrt(q / 2^32) into y * 2^(k - 30), q != 0
+constexpr auto rsqrt_parts(uint64_t q, int32_t& k) -> uint64_t
+{
+    k = 0;
+    while(q < (uint64_t(1) << 62))
+    {
+        q <<= 2;
+        ++k;
+    }
+    return rsqrt_unit(static_cast<uint32_t>(q >> 32));
+}
+
+}
+
+//1/d kept as a 2.30 mantissa and a shift, so dividing several values by the same d costs one multiply each
+//quotients round to nearest where operator/ truncates, a zero d divides everything to 0
+class Reciprocal
+{
+public:
+    int64_t y = 0;
+    int32_t shift = 0;
+
+    constexpr auto operator()(fixed32 const n) const -> fixed32
+    {
+        return fromRaw(static_cast<int32_t>((n.data * y + (int64_t(1) << (shift - 1))) >> shift));
+    }
+};
+
+//no integer divide, a leading zero count, one table read and two newton steps
+constexpr auto reciprocal(fixed32 const d) -> Reciprocal
+{
+    if(d.data == 0)
+    {
+        return {};
+    }
+    uint32_t const a = d.data < 0 ? uint32_t(0) - uint32_t(d.data) : uint32_t(d.data);
+    int32_t const k = std::countl_zero(a);
+    int64_t const y = static_cast<int64_t>(detail::recip_unit(a << k));
+    //n / d = n * y * 2^(k - 62) in raw units, plus 16 for the fractional bits
+    return {d.data < 0 ? -y : y, 46 - k};
+}
+
 constexpr auto sqrt(fixed32 const n) -> fixed32
 {
-    return static_cast<fixed32>(std::sqrtf(static_cast<float>(n)));
+    if(n.data <= 0)
+    {
+        return fromRaw(0);
+    }
+    return fromRaw(static_cast<int32_t>(detail::isqrt(uint64_t(n.data) << 16)));
 }
 
+//1/sqrt(n), saturates at the largest fixed32 for tiny n
+constexpr auto rsqrt(fixed32 const n) -> fixed32
+{
+    if(n.data <= 0)
+    {
+        return fromRaw(INT32_MAX);
+    }
+    int32_t k = 0;
+    uint64_t const y = detail::rsqrt_parts(uint64_t(n.data) << 16, k);
+    uint64_t const r = k >= 30 ? y << (k - 30) : (y + (uint64_t(1) << (29 - k))) >> (30 - k);
+    return fromRaw(r > INT32_MAX ? INT32_MAX : static_cast<int32_t>(r));
+}
+
+//angles in radians
 constexpr auto sin(fixed32 const n) -> fixed32
 {
-    return static_cast<fixed32>(std::sinf(static_cast<float>(n)));
+    return fromRaw(detail::sin_phase((int64_t(n.data) * detail::RAD_TO_SEGMENTS) >> 24));
 }
 
 constexpr auto cos(fixed32 const n) -> fixed32
 {
-    return static_cast<fixed32>(std::cosf(static_cast<float>(n)));
+    return fromRaw(detail::sin_phase(((int64_t(n.data) * detail::RAD_TO_SEGMENTS) >> 24) + (int64_t(1) << 24)));
 }
 
-template<class T, std::size_t S, auto FUNC>
-constexpr auto makeTable() -> std::array<T, S>
+//angle of (x, y) in -pi..pi
+constexpr auto atan2(fixed32 const y, fixed32 const x) -> fixed32
 {
-    std::array<T,S> r{};
-    for(std::size_t i = 0; i < S; ++i)
+    int64_t const ax = x.data < 0 ? -int64_t(x.data) : x.data;
+    int64_t const ay = y.data < 0 ? -int64_t(y.data) : y.data;
+    if(ax == 0 && ay == 0)
     {
-        r[i] = FUNC(i);
+        return fromRaw(0);
     }
-    return r;
+
+    constexpr int32_t half_pi = 102944;
+    constexpr int32_t pi = 205887;
+
+    //reduce to the first octant, ratio in 8.16 table segments
+    int32_t a = 0;
+    if(ax >= ay)
+    {
+        a = detail::lerp_table(detail::atan_table, static_cast<uint32_t>((ay << (16 + detail::TRIG_BITS)) / ax));
+    }
+    else
+    {
+        a = half_pi - detail::lerp_table(detail::atan_table, static_cast<uint32_t>((ax << (16 + detail::TRIG_BITS)) / ay));
+    }
+
+    if(x.data < 0)
+    {
+        a = pi - a;
+    }
+    return fromRaw(y.data < 0 ? -a : a);
 }
 
+static_assert(sqrt(fromRaw(4 << 16)).data == (2 << 16));
+static_assert(sqrt(fromRaw(2 << 16)).data == 92681);
+static_assert(rsqrt(fromRaw(4 << 16)).data == (1 << 15));
+static_assert(reciprocal(fromRaw(2 << 16))(fromRaw(1 << 16)).data == (1 << 15));
+static_assert(reciprocal(fromRaw(-3 << 16))(fromRaw(3 << 16)).data == -(1 << 16));
+static_assert(sin(fromRaw(0)).data == 0);
+static_assert(cos(fromRaw(0)).data == 65536);
+static_assert(sin(fromRaw(34315)).data - 32768 <= 2 && sin(fromRaw(34315)).data - 32768 >= -2); //pi/6
+static_assert(atan2(fromRaw(65536), fromRaw(65536)).data - 51472 <= 2 && atan2(fromRaw(65536), fromRaw(65536)).data - 51472 >= -2);
 
-class vec2
+//scales n consecutive components by 1/sqrt(sq), sq is the sum of raw squares
+//stays in 64 bit so long vectors keep their precision
+constexpr void detail_normalize(fixed32* c, int const n, uint64_t const sq)
+{
+    if(sq == 0)
+    {
+        return;
+    }
+    int32_t k = 0;
+    uint64_t const y = detail::rsqrt_parts(sq, k);
+    int32_t const shift = 46 - k;
+    for(int i = 0; i < n; ++i)
+    {
+        int64_t const v = int64_t(c[i].data) * int64_t(y);
+        c[i].data = static_cast<int32_t>(shift >= 0 ? v >> shift : v << -shift);
+    }
+}
+
+//fixed32 is the reference scalar, float and double instantiate the same vector and matrix code
+//for hosts where hardware floating point beats emulated 16.16
+template<class T>
+concept Scalar = std::is_same_v<T, fixed32> || std::is_floating_point_v<T>;
+
+//converts between the scalar types, fixed32 goes through its raw value so double keeps every bit
+//conversion to fixed32 truncates like the fixed32(float) constructor
+template<Scalar U, Scalar T>
+constexpr auto scalar_cast(T const v) -> U
+{
+    if constexpr (std::is_same_v<U, T>)
+    {
+        return v;
+    }
+    else if constexpr (std::is_same_v<T, fixed32>)
+    {
+        return U(v.data) / U(65536);
+    }
+    else if constexpr (std::is_same_v<U, fixed32>)
+    {
+        return fromRaw(static_cast<int32_t>(v * T(65536)));
+    }
+    else
+    {
+        return static_cast<U>(v);
+    }
+}
+
+inline auto sqrt(std::floating_point auto const n)
+{
+    return std::sqrt(n);
+}
+
+inline auto sin(std::floating_point auto const n)
+{
+    return std::sin(n);
+}
+
+inline auto cos(std::floating_point auto const n)
+{
+    return std::cos(n);
+}
+
+template<Scalar T>
+class basic_vec2
 {
 public:
-    fixed32 x,y;
+    T x,y;
 
-    constexpr auto operator + (vec2 const & that) const -> vec2
+    constexpr auto operator + (basic_vec2 const & that) const -> basic_vec2
     {
         return {x+that.x, y+that.y};
     }
 
-    constexpr auto operator - (vec2 const & that) const -> vec2
+    constexpr auto operator - (basic_vec2 const & that) const -> basic_vec2
     {
         return {x-that.x, y-that.y};
     }
 
-    constexpr auto operator * (fixed32 const & that) const -> vec2
+    constexpr auto operator * (T const & that) const -> basic_vec2
     {
         return {x*that,y*that};
     }
 
-    constexpr auto operator / (fixed32 const & that) const -> vec2
+    constexpr auto operator / (T const & that) const -> basic_vec2
     {
         return {x/that,y/that};
     }
 
-    [[nodiscard]] constexpr auto length() const -> fixed32
+    //fixed32 sums the squared components at full precision before the root
+    [[nodiscard]] constexpr auto length() const -> T
     {
-        const auto x2 = x*x;
-        const auto y2 = y*y;
-        const auto sum = x2+y2;
-        return sqrt(sum);
+        if constexpr (std::is_same_v<T, fixed32>)
+        {
+            return fromRaw(static_cast<int32_t>(detail::isqrt(squaredLength64())));
+        }
+        else
+        {
+            return sqrt(x*x + y*y);
+        }
     }
 
-    auto operator[](uint8_t const p) -> fixed32&
+    [[nodiscard]] constexpr auto normalize() const -> basic_vec2
+    {
+        if constexpr (std::is_same_v<T, fixed32>)
+        {
+            basic_vec2 r = *this;
+            detail_normalize(&r.x, 2, squaredLength64());
+            return r;
+        }
+        else
+        {
+            T const l = length();
+            return l != T(0) ? *this / l : *this;
+        }
+    }
+
+    //sum of the raw squares, 32 fractional bits
+    [[nodiscard]] constexpr auto squaredLength64() const -> uint64_t requires std::is_same_v<T, fixed32>
+    {
+        return uint64_t(int64_t(x.data) * x.data) + uint64_t(int64_t(y.data) * y.data);
+    }
+
+    auto operator[](uint8_t const p) -> T&
     {
         return *((&(this->x)) + p);
 
     }
 };
 
-class vec3 : public vec2
+template<Scalar T>
+class basic_vec3 : public basic_vec2<T>
 {
 public:
-    fixed32 z;
+    T z;
 
-    constexpr auto operator + (vec3 const & that) -> vec3
+    constexpr auto operator + (basic_vec3 const & that) -> basic_vec3
     {
-        return {this->x+that.x, this->y+that.y, z+that.x};
+        return {this->x+that.x, this->y+that.y, z+that.z};
     }
 
-    constexpr auto operator - (vec3 const & that) -> vec3
+    constexpr auto operator - (basic_vec3 const & that) -> basic_vec3
     {
-        return {this->x-that.x, this->y-that.y, z-that.x};
+        return {this->x-that.x, this->y-that.y, z-that.z};
     }
 
-    constexpr auto operator * (fixed32 const & that) -> vec3
+    constexpr auto operator * (T const & that) -> basic_vec3
     {
         return {this->x*that,this->y*that,this->z*that};
     }
 
-    constexpr auto operator / (fixed32 const & that) -> vec3
+    constexpr auto operator / (T const & that) -> basic_vec3
     {
         return {this->x/that,this->y/that,this->z/that};
     }
 
-    constexpr auto operator * (vec3 const & that) -> fixed32
+    constexpr auto operator * (basic_vec3 const & that) -> T
     {
         return { (this->x*that.x) + (this->y*that.y) + (this->z*that.z) };
     }
 
-    [[nodiscard]] constexpr auto length() const -> fixed32
+    [[nodiscard]] constexpr auto length() const -> T
+    {
+        if constexpr (std::is_same_v<T, fixed32>)
+        {
+            return fromRaw(static_cast<int32_t>(detail::isqrt(squaredLength64())));
+        }
+        else
+        {
+            return sqrt(this->x*this->x + this->y*this->y + z*z);
+        }
+    }
+
+    [[nodiscard]] constexpr auto normalize() const -> basic_vec3
+    {
+        basic_vec3 r = *this;
+        if constexpr (std::is_same_v<T, fixed32>)
+        {
+            detail_normalize(&r.x, 3, squaredLength64());
+        }
+        else if(T const l = length(); l != T(0))
+        {
+            r = {{this->x/l, this->y/l}, z/l};
+        }
+        return r;
+    }
+
+    [[nodiscard]] constexpr auto squaredLength64() const -> uint64_t requires std::is_same_v<T, fixed32>
     {
-        const auto x2 = x*x;
-        const auto y2 = y*y;
-        const auto z2 = z*z;
-        const auto sum = x2+y2+z2;
-        return sqrt(sum);
+        return basic_vec2<T>::squaredLength64() + uint64_t(int64_t(z.data) * z.data);
     }
 };
 
-class vec4 : public vec3
+template<Scalar T>
+class basic_vec4 : public basic_vec3<T>
 {
 public:
-    fixed32 w;
+    T w;
 
-    constexpr auto operator + (vec4 const & that) const -> vec4
+    constexpr auto operator + (basic_vec4 const & that) const -> basic_vec4
     {
-        return {this->x+that.x, this->y+that.y, z+that.x, w+that.w};
+        return {this->x+that.x, this->y+that.y, this->z+that.z, w+that.w};
     }
 
-    constexpr auto operator - (vec4 const & that) const -> vec4
+    constexpr auto operator - (basic_vec4 const & that) const -> basic_vec4
     {
-        return {this->x-that.x, this->y-that.y, z-that.x, w-that.w};
+        return {this->x-that.x, this->y-that.y, this->z-that.z, w-that.w};
     }
 
-    constexpr auto operator * (fixed32 const & that) const -> vec4
+    constexpr auto operator * (T const & that) const -> basic_vec4
     {
         return {this->x*that,this->y*that,this->z*that,w*that};
     }
 
-    constexpr auto operator / (fixed32 const & that) const -> vec4
+    constexpr auto operator / (T const & that) const -> basic_vec4
     {
         return {this->x/that,this->y/that,this->z/that,w/that};
     }
 
-    constexpr auto operator * (vec4 const & that) const -> fixed32
+    constexpr auto operator * (basic_vec4 const & that) const -> T
     {
         return { (this->x*that.x) + (this->y*that.y) + (this->z*that.z) + (this->w*that.w) };
     }
 
-    [[nodiscard]] constexpr auto length() const -> fixed32
+    [[nodiscard]] constexpr auto length() const -> T
     {
-        const auto x2 = x*x;
-        const auto y2 = y*y;
-        const auto z2 = z*z;
-        const auto w2 = w*w;
-        const auto sum = x2+y2+z2+w2;
-        return sqrt(sum);
+        if constexpr (std::is_same_v<T, fixed32>)
+        {
+            return fromRaw(static_cast<int32_t>(detail::isqrt(squaredLength64())));
+        }
+        else
+        {
+            return sqrt(this->x*this->x + this->y*this->y + this->z*this->z + w*w);
+        }
+    }
+
+    [[nodiscard]] constexpr auto normalize() const -> basic_vec4
+    {
+        if constexpr (std::is_same_v<T, fixed32>)
+        {
+            basic_vec4 r = *this;
+            detail_normalize(&r.x, 4, squaredLength64());
+            return r;
+        }
+        else
+        {
+            T const l = length();
+            return l != T(0) ? *this / l : *this;
+        }
+    }
+
+    [[nodiscard]] constexpr auto squaredLength64() const -> uint64_t requires std::is_same_v<T, fixed32>
+    {
+        return basic_vec3<T>::squaredLength64() + uint64_t(int64_t(w.data) * w.data);
     }
 
 };
 
-class mat4
+//column major, m[column][row]
+template<Scalar T>
+class basic_mat4
 {
 public:
-    fixed32 m[4][4];
+    T m[4][4];
 
-    constexpr auto operator + (mat4 const & that) -> mat4
+    constexpr auto operator + (basic_mat4 const & that) const -> basic_mat4
     {
-        mat4 n;
+        basic_mat4 n;
 
         for(uint8_t c = 0; c < 4; ++c)
         {
@@ -273,8 +689,103 @@ public:
 
         return n;
     }
+
+    //fixed32 dot products accumulate the full 64 bit products and shift once at the end,
+    //the simd kernels below produce bit identical results
+    constexpr auto operator * (basic_vec4<T> const & that) const -> basic_vec4<T>
+    {
+        basic_vec4<T> r{};
+        T* const out[4] = {&r.x, &r.y, &r.z, &r.w};
+
+        for(uint8_t row = 0; row < 4; ++row)
+        {
+            if constexpr (std::is_same_v<T, fixed32>)
+            {
+                int64_t const acc = int64_t(m[0][row].data) * that.x.data +
+                                    int64_t(m[1][row].data) * that.y.data +
+                                    int64_t(m[2][row].data) * that.z.data +
+                                    int64_t(m[3][row].data) * that.w.data;
+                out[row]->data = static_cast<int32_t>(acc >> 16);
+            }
+            else
+            {
+                *out[row] = m[0][row] * that.x + m[1][row] * that.y + m[2][row] * that.z + m[3][row] * that.w;
+            }
+        }
+
+        return r;
+    }
+
+    constexpr auto operator * (basic_mat4 const & that) const -> basic_mat4
+    {
+        basic_mat4 n;
+
+        for(uint8_t c = 0; c < 4; ++c)
+        {
+            basic_vec4<T> const col = (*this) * basic_vec4<T>{that.m[c][0], that.m[c][1], that.m[c][2], that.m[c][3]};
+            n.m[c][0] = col.x;
+            n.m[c][1] = col.y;
+            n.m[c][2] = col.z;
+            n.m[c][3] = col.w;
+        }
+
+        return n;
+    }
+
+    constexpr auto operator == (basic_mat4 const & that) const -> bool
+    {
+        for(uint8_t c = 0; c < 4; ++c)
+        {
+            for(uint8_t r = 0; r < 4; ++r)
+            {
+                if((m[c][r] <=> that.m[c][r]) != 0)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
 };
 
+using vec2 = basic_vec2<fixed32>;
+using vec3 = basic_vec3<fixed32>;
+using vec4 = basic_vec4<fixed32>;
+using mat4 = basic_mat4<fixed32>;
+
+using vec2f = basic_vec2<float>;
+using vec3f = basic_vec3<float>;
+using vec4f = basic_vec4<float>;
+using mat4f = basic_mat4<float>;
+
+using vec2d = basic_vec2<double>;
+using vec3d = basic_vec3<double>;
+using vec4d = basic_vec4<double>;
+using mat4d = basic_mat4<double>;
+
+static_assert(sizeof(vec4) == 4 * sizeof(fixed32), "vec4 must be four packed fixed32, the batch kernels rely on it");
+
+template<Scalar U, Scalar T>
+constexpr auto cast(basic_vec4<T> const & v) -> basic_vec4<U>
+{
+    return {scalar_cast<U>(v.x), scalar_cast<U>(v.y), scalar_cast<U>(v.z), scalar_cast<U>(v.w)};
+}
+
+template<Scalar U, Scalar T>
+constexpr auto cast(basic_mat4<T> const & m) -> basic_mat4<U>
+{
+    basic_mat4<U> n;
+    for(uint8_t c = 0; c < 4; ++c)
+    {
+        for(uint8_t r = 0; r < 4; ++r)
+        {
+            n.m[c][r] = scalar_cast<U>(m.m[c][r]);
+        }
+    }
+    return n;
+}
+
 consteval math::fixed32 operator""_fx(long double f)
 {
     math::fixed32 r(static_cast<float>(f));
@@ -284,11 +795,363 @@ consteval math::fixed32 operator""_fx(long double f)
 
 auto mix(auto x, auto y, auto a) -> auto
 {
-    return x * (1.0_fx - a) + y * a;
+    return x * (decltype(a)(1.0f) - a) + y * a;
 }
 
 constexpr fixed32 PI = 3.14159265_fx;
 
+template<Scalar T = fixed32>
+constexpr auto identity() -> basic_mat4<T>
+{
+    basic_mat4<T> n{};
+    n.m[0][0] = T(1.0f);
+    n.m[1][1] = T(1.0f);
+    n.m[2][2] = T(1.0f);
+    n.m[3][3] = T(1.0f);
+    return n;
+}
+
+template<Scalar T>
+constexpr auto translate(basic_vec3<T> const & t) -> basic_mat4<T>
+{
+    basic_mat4<T> n = identity<T>();
+    n.m[3][0] = t.x;
+    n.m[3][1] = t.y;
+    n.m[3][2] = t.z;
+    return n;
+}
+
+template<Scalar T>
+constexpr auto scale(basic_vec3<T> const & s) -> basic_mat4<T>
+{
+    basic_mat4<T> n{};
+    n.m[0][0] = s.x;
+    n.m[1][1] = s.y;
+    n.m[2][2] = s.z;
+    n.m[3][3] = T(1.0f);
+    return n;
+}
+
+//fixed32 overloads, braced arguments like translate({{x, y}, z}) cannot deduce the template
+constexpr auto translate(vec3 const & t) -> mat4
+{
+    return translate<fixed32>(t);
+}
+
+constexpr auto scale(vec3 const & s) -> mat4
+{
+    return scale<fixed32>(s);
+}
+
+//axis must be normalized, angle in radians
+template<Scalar T>
+constexpr auto rotate(T const angle, basic_vec3<T> const & axis) -> basic_mat4<T>
+{
+    T const c = cos(angle);
+    T const s = sin(angle);
+    T const t = T(1.0f) - c;
+    T const x = axis.x;
+    T const y = axis.y;
+    T const z = axis.z;
+
+    basic_mat4<T> n = identity<T>();
+    n.m[0][0] = t*x*x + c;
+    n.m[0][1] = t*x*y + s*z;
+    n.m[0][2] = t*x*z - s*y;
+    n.m[1][0] = t*x*y - s*z;
+    n.m[1][1] = t*y*y + c;
+    n.m[1][2] = t*y*z + s*x;
+    n.m[2][0] = t*x*z + s*y;
+    n.m[2][1] = t*y*z - s*x;
+    n.m[2][2] = t*z*z + c;
+    return n;
+}
+
+//same conventions as glOrtho, maps the box to the -1..1 clip cube
+template<Scalar T>
+constexpr auto ortho(T const left, T const right,
+                     T const bottom, T const top,
+                     T const zNear, T const zFar) -> basic_mat4<T>
+{
+    basic_mat4<T> n = identity<T>();
+    n.m[0][0] = T(2.0f) / (right - left);
+    n.m[1][1] = T(2.0f) / (top - bottom);
+    n.m[2][2] = T(-2.0f) / (zFar - zNear);
+    n.m[3][0] = -(right + left) / (right - left);
+    n.m[3][1] = -(top + bottom) / (top - bottom);
+    n.m[3][2] = -(zFar + zNear) / (zFar - zNear);
+    return n;
+}
+
+template<Scalar T>
+constexpr auto ortho(T const left, T const right,
+                     T const bottom, T const top) -> basic_mat4<T>
+{
+    return ortho(left, right, bottom, top, T(-1.0f), T(1.0f));
+}
+
+//same conventions as gluPerspective, fovy in radians
+//in fixed32 keep zFar*zNear below ~16000 or the 16.16 range overflows
+template<Scalar T>
+constexpr auto perspective(T const fovy, T const aspect,
+                           T const zNear, T const zFar) -> basic_mat4<T>
+{
+    T const half = fovy / T(2.0f);
+    T const f = cos(half) / sin(half);
+
+    basic_mat4<T> n{};
+    n.m[0][0] = f / aspect;
+    n.m[1][1] = f;
+    n.m[2][2] = (zFar + zNear) / (zNear - zFar);
+    n.m[2][3] = T(-1.0f);
+    n.m[3][2] = (T(2.0f) * zFar * zNear) / (zNear - zFar);
+    return n;
+}
+
+//batch transform, out[i] = m * in[i], out may alias in
+//uses the 32x32->64 signed multiplies of avx2/sse4.1 when the target has them
+inline void transform(mat4 const & m, std::span<const vec4> in, std::span<vec4> out)
+{
+    std::size_t const n = in.size() < out.size() ? in.size() : out.size();
+    int32_t const* src = reinterpret_cast<int32_t const*>(in.data());
+    int32_t* dst = reinterpret_cast<int32_t*>(out.data());
+
+#if defined(__AVX2__)
+    //each 64 bit lane holds one row, mul_epi32 multiplies the low 32 bits of each lane
+    __m256i const c0 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&m.m[0][0])));
+    __m256i const c1 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&m.m[1][0])));
+    __m256i const c2 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&m.m[2][0])));
+    __m256i const c3 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&m.m[3][0])));
+    __m256i const pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    for(std::size_t i = 0; i < n; ++i, src += 4, dst += 4)
+    {
+        __m256i acc = _mm256_mul_epi32(c0, _mm256_set1_epi32(src[0]));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(c1, _mm256_set1_epi32(src[1])));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(c2, _mm256_set1_epi32(src[2])));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(c3, _mm256_set1_epi32(src[3])));
+        //only the low 32 bits survive, so a logical shift matches the arithmetic one
+        acc = _mm256_srli_epi64(acc, 16);
+        acc = _mm256_permutevar8x32_epi32(acc, pack);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(acc));
+    }
+#elif defined(__SSE4_1__)
+    //mul_epi32 only uses lanes 0 and 2, so rows 0/2 and 1/3 are accumulated separately
+    __m128i ce[4], co[4];
+    for(uint8_t c = 0; c < 4; ++c)
+    {
+        ce[c] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&m.m[c][0]));
+        co[c] = _mm_srli_epi64(ce[c], 32);
+    }
+
+    for(std::size_t i = 0; i < n; ++i, src += 4, dst += 4)
+    {
+        __m128i even = _mm_setzero_si128();
+        __m128i odd = _mm_setzero_si128();
+        for(uint8_t c = 0; c < 4; ++c)
+        {
+            __m128i const v = _mm_set1_epi32(src[c]);
+            even = _mm_add_epi64(even, _mm_mul_epi32(ce[c], v));
+            odd = _mm_add_epi64(odd, _mm_mul_epi32(co[c], v));
+        }
+        even = _mm_srli_epi64(even, 16);
+        odd = _mm_slli_epi64(_mm_srli_epi64(odd, 16), 32);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_blend_epi16(even, odd, 0xCC));
+    }
+#else
+    (void)src;
+    (void)dst;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        out[i] = m * in[i];
+    }
+#endif
+}
+
+//structure of arrays kernels working on raw 16.16 lanes
+//arrays must be padded to a multiple of SOA_LANES, the simd paths run over the padding too
+constexpr std::size_t SOA_LANES = 8;
+
+//in place (x, y, z, w) = m * (x, y, z, w), bit identical to mat4 * vec4
+inline void transform(mat4 const & m, int32_t* x, int32_t* y, int32_t* z, int32_t* w, std::size_t const n)
+{
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#if defined(__AVX2__)
+    using reg = __m256i;
+    constexpr std::size_t lanes = 8;
+    auto const load = [](int32_t const* p) { return _mm256_load_si256(reinterpret_cast<reg const*>(p)); };
+    auto const store = [](int32_t* p, reg v) { _mm256_store_si256(reinterpret_cast<reg*>(p), v); };
+    auto const set1 = [](int32_t v) { return _mm256_set1_epi32(v); };
+    auto const mul = [](reg a, reg b) { return _mm256_mul_epi32(a, b); };
+    auto const add = [](reg a, reg b) { return _mm256_add_epi64(a, b); };
+    auto const hi = [](reg a) { return _mm256_srli_epi64(a, 32); };
+    //even lanes hold the low half of each 64 bit product, odd lanes are shifted up into place
+    auto const merge = [](reg even, reg odd)
+    {
+        return _mm256_blend_epi32(_mm256_srli_epi64(even, 16), _mm256_slli_epi64(_mm256_srli_epi64(odd, 16), 32), 0xAA);
+    };
+#else
+    using reg = __m128i;
+    constexpr std::size_t lanes = 4;
+    auto const load = [](int32_t const* p) { return _mm_load_si128(reinterpret_cast<reg const*>(p)); };
+    auto const store = [](int32_t* p, reg v) { _mm_store_si128(reinterpret_cast<reg*>(p), v); };
+    auto const set1 = [](int32_t v) { return _mm_set1_epi32(v); };
+    auto const mul = [](reg a, reg b) { return _mm_mul_epi32(a, b); };
+    auto const add = [](reg a, reg b) { return _mm_add_epi64(a, b); };
+    auto const hi = [](reg a) { return _mm_srli_epi64(a, 32); };
+    auto const merge = [](reg even, reg odd)
+    {
+        return _mm_blend_epi16(_mm_srli_epi64(even, 16), _mm_slli_epi64(_mm_srli_epi64(odd, 16), 32), 0xCC);
+    };
+#endif
+    reg mm[4][4];
+    for(uint8_t c = 0; c < 4; ++c)
+    {
+        for(uint8_t r = 0; r < 4; ++r)
+        {
+            mm[c][r] = set1(m.m[c][r].data);
+        }
+    }
+
+    for(std::size_t i = 0; i < n; i += lanes)
+    {
+        reg const in[4] = {load(x + i), load(y + i), load(z + i), load(w + i)};
+        reg const odd[4] = {hi(in[0]), hi(in[1]), hi(in[2]), hi(in[3])};
+        reg out[4];
+        for(uint8_t r = 0; r < 4; ++r)
+        {
+            reg e = mul(in[0], mm[0][r]);
+            reg o = mul(odd[0], mm[0][r]);
+            for(uint8_t c = 1; c < 4; ++c)
+            {
+                e = add(e, mul(in[c], mm[c][r]));
+                o = add(o, mul(odd[c], mm[c][r]));
+            }
+            out[r] = merge(e, o);
+        }
+        store(x + i, out[0]);
+        store(y + i, out[1]);
+        store(z + i, out[2]);
+        store(w + i, out[3]);
+    }
+#else
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        vec4 const v = m * vec4{fromRaw(x[i]), fromRaw(y[i]), fromRaw(z[i]), fromRaw(w[i])};
+        x[i] = v.x.data;
+        y[i] = v.y.data;
+        z[i] = v.z.data;
+        w[i] = v.w.data;
+    }
+#endif
+}
+
+//window transform applied after the divide, per axis v * scale + bias
+template<Scalar T>
+struct Viewport
+{
+    T scale[3];
+    T bias[3];
+};
+
+//in place perspective divide and window transform in one pass, w = 1 afterwards
+//1/w is taken once per vertex and every axis multiplies by it, lanes with w == 0 come out as INT32_MIN or are left alone
+//the sse2 and avx paths, so every x86-64 build, keep a hardware double divide, one per vertex is cheaper
+//than a newton iteration per lane, only builds without them use the fixed32 reciprocal
+inline void project(int32_t* x, int32_t* y, int32_t* z, int32_t* w, std::size_t const n, Viewport<fixed32> const & vp)
+{
+#if defined(__AVX__)
+    __m256d const one = _mm256_set1_pd(1.0);
+    __m128i const unit = _mm_set1_epi32(65536);
+    int32_t* const c[3] = {x, y, z};
+    __m256d const s[3] = {_mm256_set1_pd(vp.scale[0].data), _mm256_set1_pd(vp.scale[1].data), _mm256_set1_pd(vp.scale[2].data)};
+    __m256d const b[3] = {_mm256_set1_pd(vp.bias[0].data), _mm256_set1_pd(vp.bias[1].data), _mm256_set1_pd(vp.bias[2].data)};
+    for(std::size_t i = 0; i < n; i += 4)
+    {
+        __m256d const r = _mm256_div_pd(one, _mm256_cvtepi32_pd(_mm_load_si128(reinterpret_cast<__m128i const*>(w + i))));
+        for(uint8_t a = 0; a < 3; ++a)
+        {
+            __m256d const cd = _mm256_cvtepi32_pd(_mm_load_si128(reinterpret_cast<__m128i const*>(c[a] + i)));
+            __m256d const v = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(cd, r), s[a]), b[a]);
+            _mm_store_si128(reinterpret_cast<__m128i*>(c[a] + i), _mm256_cvttpd_epi32(v));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(w + i), unit);
+    }
+#elif defined(__SSE2__)
+    __m128d const one = _mm_set1_pd(1.0);
+    __m128i const unit = _mm_set1_epi32(65536);
+    int32_t* const c[3] = {x, y, z};
+    for(std::size_t i = 0; i < n; i += 4)
+    {
+        __m128i const wi = _mm_load_si128(reinterpret_cast<__m128i const*>(w + i));
+        __m128d const rlo = _mm_div_pd(one, _mm_cvtepi32_pd(wi));
+        __m128d const rhi = _mm_div_pd(one, _mm_cvtepi32_pd(_mm_srli_si128(wi, 8)));
+        for(uint8_t a = 0; a < 3; ++a)
+        {
+            __m128d const s = _mm_set1_pd(vp.scale[a].data);
+            __m128d const b = _mm_set1_pd(vp.bias[a].data);
+            __m128i const ci = _mm_load_si128(reinterpret_cast<__m128i const*>(c[a] + i));
+            __m128i const lo = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(_mm_cvtepi32_pd(ci), rlo), s), b));
+            __m128i const hi = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(ci, 8)), rhi), s), b));
+            _mm_store_si128(reinterpret_cast<__m128i*>(c[a] + i), _mm_unpacklo_epi64(lo, hi));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(w + i), unit);
+    }
+#else
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        if(w[i] == 0)
+        {
+            continue;
+        }
+        Reciprocal const r = reciprocal(fromRaw(w[i]));
+        x[i] = (r(fromRaw(x[i])) * vp.scale[0] + vp.bias[0]).data;
+        y[i] = (r(fromRaw(y[i])) * vp.scale[1] + vp.bias[1]).data;
+        z[i] = (r(fromRaw(z[i])) * vp.scale[2] + vp.bias[2]).data;
+        w[i] = 65536;
+    }
+#endif
+}
+
+//floating point versions of the soa kernels
+//each block of SOA_LANES is a fixed length loop over locals, which the compiler vectorizes without alias checks
+template<std::floating_point T>
+inline void transform(basic_mat4<T> const & m, T* x, T* y, T* z, T* w, std::size_t const n)
+{
+    for(std::size_t i = 0; i < n; i += SOA_LANES)
+    {
+        T in[4][SOA_LANES];
+        for(std::size_t l = 0; l < SOA_LANES; ++l)
+        {
+            in[0][l] = x[i + l];
+            in[1][l] = y[i + l];
+            in[2][l] = z[i + l];
+            in[3][l] = w[i + l];
+        }
+        T* const out[4] = {x + i, y + i, z + i, w + i};
+        for(uint8_t r = 0; r < 4; ++r)
+        {
+            for(std::size_t l = 0; l < SOA_LANES; ++l)
+            {
+                out[r][l] = m.m[0][r] * in[0][l] + m.m[1][r] * in[1][l] + m.m[2][r] * in[2][l] + m.m[3][r] * in[3][l];
+            }
+        }
+    }
+}
+
+template<std::floating_point T>
+inline void project(T* x, T* y, T* z, T* w, std::size_t const n, Viewport<T> const & vp)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        T const r = T(1) / w[i];
+        x[i] = x[i] * r * vp.scale[0] + vp.bias[0];
+        y[i] = y[i] * r * vp.scale[1] + vp.bias[1];
+        z[i] = z[i] * r * vp.scale[2] + vp.bias[2];
+        w[i] = T(1);
+    }
+}
+
 }
 
 consteval fren::math::fixed32 operator""_fx(long double f)
@@ -296,4 +1159,3 @@ consteval fren::math::fixed32 operator""_fx(long double f)
     fren::math::fixed32 r(static_cast<float>(f));
     return r;
 }
-
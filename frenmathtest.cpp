@@ -0,0 +1,157 @@
+#include "frenmath.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+//sweeps the integer math kernels against double and checks the accuracy documented in frenmath.hpp
+//every raw input below 2^20 and a dense stride above it, so the run stays in the seconds
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::fromRaw;
+
+int failures = 0;
+
+void check(char const* name, double const error, double const bound, char const* unit = "lsb")
+{
+    bool const ok = error <= bound;
+    std::printf("%-12s %10.4f %s, bound %.4f %s\n", name, error, unit, bound, ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+//every raw value below 2^20, then every stride-th one up to INT32_MAX
+template<class F>
+void sweep_positive(int64_t const stride, F&& f)
+{
+    for(int64_t r = 0; r <= INT32_MAX; r += r < (int64_t(1) << 20) ? 1 : stride)
+    {
+        f(static_cast<int32_t>(r));
+    }
+}
+
+//the floor of the true root, checked exactly in integers
+void test_sqrt()
+{
+    int64_t wrong = 0;
+    sweep_positive(997, [&](int32_t const r)
+    {
+        uint64_t const v = uint64_t(r) << 16;
+        uint64_t const s = static_cast<uint64_t>(fren::math::sqrt(fromRaw(r)).data);
+        wrong += s * s <= v && (s + 1) * (s + 1) > v ? 0 : 1;
+    });
+    //isqrt itself on 64 bit inputs, right at and just below perfect squares
+    for(uint64_t k = 1; k < (uint64_t(1) << 31); k += 65521)
+    {
+        wrong += fren::math::detail::isqrt(k * k) == k ? 0 : 1;
+        wrong += fren::math::detail::isqrt(k * k - 1) == k - 1 ? 0 : 1;
+    }
+    check("sqrt", double(wrong), 0);
+}
+
+void test_rsqrt()
+{
+    double error = 0;
+    sweep_positive(997, [&](int32_t const r)
+    {
+        if(r == 0)
+        {
+            return;
+        }
+        double const want = std::min(65536.0 / std::sqrt(r / 65536.0), double(INT32_MAX));
+        error = std::max(error, std::fabs(fren::math::rsqrt(fromRaw(r)).data - want));
+    });
+    check("rsqrt", error, 0.51);
+}
+
+void test_trig()
+{
+    double error_sin = 0;
+    double error_cos = 0;
+    for(int64_t r = INT32_MIN; r <= INT32_MAX; r += 1021)
+    {
+        double const a = r / 65536.0;
+        fixed32 const n = fromRaw(static_cast<int32_t>(r));
+        error_sin = std::max(error_sin, std::fabs(fren::math::sin(n).data - 65536.0 * std::sin(a)));
+        error_cos = std::max(error_cos, std::fabs(fren::math::cos(n).data - 65536.0 * std::cos(a)));
+    }
+    check("sin", error_sin, 2);
+    check("cos", error_cos, 2);
+}
+
+//every divisor below 2^20 and a stride above, both signs, against random numerators of random magnitude
+//quotients that overflow int32 are skipped, beyond |n| <= |d| the error past rounding is measured relative
+void test_reciprocal()
+{
+    std::mt19937_64 rng(2);
+    double error = 0;
+    double relative = 0;
+    sweep_positive(997, [&](int32_t const r)
+    {
+        for(int32_t const d : {r, -r})
+        {
+            if(d == 0)
+            {
+                continue;
+            }
+            fren::math::Reciprocal const q = fren::math::reciprocal(fromRaw(d));
+            for(int i = 0; i < 4; ++i)
+            {
+                int32_t const n = static_cast<int32_t>(rng()) >> (rng() % 32);
+                double const want = 65536.0 * double(n) / double(d);
+                if(std::fabs(want) >= double(INT32_MAX))
+                {
+                    continue;
+                }
+                double const e = std::fabs(q(fromRaw(n)).data - want);
+                if(std::abs(int64_t(n)) <= std::abs(int64_t(d)))
+                {
+                    error = std::max(error, e);
+                }
+                else
+                {
+                    relative = std::max(relative, (e - 0.5) / std::fabs(want));
+                }
+            }
+        }
+    });
+    check("reciprocal", error, 1);
+    check("recip large", std::ldexp(relative, 29), 1, "x 2^-29");
+}
+
+//random pairs with random magnitudes, so tiny and huge ratios and all four quadrants come up
+void test_atan2()
+{
+    std::mt19937_64 rng(1);
+    double error = 0;
+    for(int i = 0; i < 4000000; ++i)
+    {
+        int32_t const y = static_cast<int32_t>(rng()) >> (rng() % 31);
+        int32_t const x = static_cast<int32_t>(rng()) >> (rng() % 31);
+        double const want = 65536.0 * std::atan2(double(y), double(x));
+        error = std::max(error, std::fabs(fren::math::atan2(fromRaw(y), fromRaw(x)).data - want));
+    }
+    for(int32_t r = -65536; r <= 65536; ++r)
+    {
+        double const want = 65536.0 * std::atan2(double(r), 65536.0);
+        error = std::max(error, std::fabs(fren::math::atan2(fromRaw(r), fromRaw(65536)).data - want));
+    }
+    check("atan2", error, 2.5);
+}
+
+}
+
+auto main() -> int
+{
+    test_sqrt();
+    test_rsqrt();
+    test_reciprocal();
+    test_trig();
+    test_atan2();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+#include "frenfb.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+//setSegmentOptimization against the same draws unoptimized, needs FREN_PIPELINE_STATS for the dropped and merged counts
+//dedup keeps the first of two segments in either direction, so a wireframe drawn twice looks like it was drawn once
+//merging axis aligned runs steps the same pixels as the single segments did
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+using fren::math::vec3;
+
+constexpr uint16_t width = 320;
+constexpr uint16_t height = 200;
+
+int failures = 0;
+
+void check(char const* name, fren::Precision const p, bool const list, bool const ok)
+{
+    char const* const precision[] = {"fixed", "float", "double"};
+    std::printf("%-36s %-6s %-9s %s\n", name, precision[static_cast<int>(p)], list ? "list" : "immediate", ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+auto same_pixels(fren::FramebufferContext const & a, fren::FramebufferContext const & b) -> bool
+{
+    uint32_t lit = 0;
+    for(uint16_t y = 0; y < height; ++y)
+    {
+        for(uint16_t x = 0; x < width; ++x)
+        {
+            if(a.pixel(x, y) != b.pixel(x, y))
+            {
+                return false;
+            }
+            lit += a.pixel(x, y) != 0 ? 1 : 0;
+        }
+    }
+    return lit > 0;
+}
+
+//rings and two poles, every vertex at its own position and every edge once
+struct Sphere
+{
+    std::vector<vec3> verts;
+    std::vector<uint16_t> edges;
+
+    Sphere()
+    {
+        constexpr uint16_t rings = 15;
+        constexpr uint16_t sectors = 24;
+        verts.push_back({{0.0_fx, 1.0_fx}, 0.0_fx});
+        for(uint16_t r = 1; r <= rings; ++r)
+        {
+            float const t = 3.14159265f * r / (rings + 1);
+            for(uint16_t s = 0; s < sectors; ++s)
+            {
+                float const p = 6.28318531f * s / sectors;
+                verts.push_back({{fixed32(std::sin(t) * std::cos(p)), fixed32(std::cos(t))}, fixed32(std::sin(t) * std::sin(p))});
+            }
+        }
+        verts.push_back({{0.0_fx, -1.0_fx}, 0.0_fx});
+
+        uint16_t const south = static_cast<uint16_t>(verts.size() - 1);
+        for(uint16_t r = 0; r < rings; ++r)
+        {
+            for(uint16_t s = 0; s < sectors; ++s)
+            {
+                uint16_t const v = 1 + r * sectors + s;
+                uint16_t const next = 1 + r * sectors + (s + 1) % sectors;
+                uint16_t const above = r == 0 ? 0 : v - sectors;
+                edges.insert(edges.end(), {v, next, above, v});
+                if(r == rings - 1)
+                {
+                    edges.insert(edges.end(), {v, south});
+                }
+            }
+        }
+    }
+};
+
+//the edges once, then each again from its other end, all in one draw
+void test_dedup(Sphere& sphere, fren::MatrixVertexFunction& camera, fren::Precision const p, bool const list)
+{
+    std::vector<uint16_t> twice = sphere.edges;
+    for(std::size_t i = 0; i < sphere.edges.size(); i += 2)
+    {
+        twice.push_back(sphere.edges[i + 1]);
+        twice.push_back(sphere.edges[i]);
+    }
+
+    fren::FramebufferContext once, deduped;
+    fren::DisplayList recorded;
+    for(fren::FramebufferContext* ctx : {&once, &deduped})
+    {
+        ctx->setViewPort(width, height);
+        ctx->setVertexFunction(&camera);
+        ctx->setPrecision(p);
+        ctx->ColorPointer(nullptr);
+        ctx->VertexPointer(3, sphere.verts.data());
+        ctx->clear();
+    }
+    once.IndexPointer(sphere.edges.data());
+    once.DrawElements(fren::DrawType::Lines, sphere.edges.size());
+
+    deduped.setSegmentOptimization({.dedup = true, .merge = false});
+    deduped.IndexPointer(twice.data());
+    if(list)
+    {
+        deduped.NewList(recorded);
+        deduped.DrawElements(fren::DrawType::Lines, twice.size());
+        deduped.EndList();
+        deduped.CallList(recorded);
+    }
+    else
+    {
+        deduped.DrawElements(fren::DrawType::Lines, twice.size());
+    }
+
+    uint64_t const dropped = deduped.pipelineStats().deduplicated;
+    check("sphere twice, reversed copies dropped", p, list, dropped == sphere.edges.size() / 2 && same_pixels(once, deduped));
+}
+
+//runs along a row and then a column in steps, joined into two segments with the pixels of the steps
+void test_merge(fren::MatrixVertexFunction& camera, fren::Precision const p, bool const list)
+{
+    std::vector<vec2> strip;
+    for(int32_t k = 0; k <= 40; ++k)
+    {
+        strip.push_back({-1.0_fx + fren::math::fromRaw(k * 3277), 0.25_fx});
+    }
+    for(int32_t k = 1; k <= 40; ++k)
+    {
+        strip.push_back({strip[40].x, 0.25_fx + fren::math::fromRaw(k * 1638)});
+    }
+
+    fren::FramebufferContext steps, merged;
+    fren::DisplayList recorded;
+    for(fren::FramebufferContext* ctx : {&steps, &merged})
+    {
+        ctx->setViewPort(width, height);
+        ctx->setVertexFunction(&camera);
+        ctx->setPrecision(p);
+        ctx->ColorPointer(nullptr);
+        ctx->VertexPointer(2, strip.data());
+        ctx->clear();
+    }
+    steps.DrawArray(fren::DrawType::Line_Strip, 0, strip.size());
+
+    merged.setSegmentOptimization({.dedup = true, .merge = true});
+    if(list)
+    {
+        merged.NewList(recorded);
+        merged.DrawArray(fren::DrawType::Line_Strip, 0, strip.size());
+        merged.EndList();
+        merged.CallList(recorded);
+    }
+    else
+    {
+        merged.DrawArray(fren::DrawType::Line_Strip, 0, strip.size());
+    }
+
+    //80 segments, the turn is the only joint that stays
+    bool const joined = merged.pipelineStats().merged == 78 && merged.pipelineStats().deduplicated == 0;
+    check("collinear strip, pixels kept", p, list, joined && same_pixels(steps, merged));
+}
+
+}
+
+auto main() -> int
+{
+    Sphere sphere;
+    fren::MatrixVertexFunction camera;
+    camera.mvp = fren::math::perspective(1.0_fx, 1.3_fx, 0.5_fx, 100.0_fx) * fren::math::translate({{0.0_fx, 0.0_fx}, -3.0_fx});
+    for(fren::Precision const p : {fren::Precision::Fixed, fren::Precision::Float, fren::Precision::Double})
+    {
+        for(bool const list : {false, true})
+        {
+            test_dedup(sphere, camera, p, list);
+            test_merge(camera, p, list);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fren
+{
+
+//fixed set of worker threads that run one parallel loop at a time
+//the calling thread takes part in every loop, so a pool of size 1 has no threads and runs inline
+class WorkerPool
+{
+public:
+    explicit WorkerPool(uint32_t const threads)
+    {
+        for(uint32_t i = 1; i < threads; ++i)
+        {
+            workers.emplace_back([this] { worker(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for(auto& t : workers)
+        {
+            t.join();
+        }
+    }
+
+    WorkerPool(WorkerPool const &) = delete;
+    auto operator=(WorkerPool const &) -> WorkerPool& = delete;
+
+    auto size() const -> uint32_t
+    {
+        return workers.size() + 1;
+    }
+
+    //calls fn(job) once for every job in [0, jobs) and returns when all of them finished
+    //jobs are handed out in order but may complete in any order
+    template<class F>
+    void run(uint32_t const jobs, F&& fn)
+    {
+        if(workers.empty() || jobs <= 1)
+        {
+            for(uint32_t j = 0; j < jobs; ++j)
+            {
+                fn(j);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = [](void* f, uint32_t const j) { (*static_cast<std::remove_reference_t<F>*>(f))(j); };
+            task_data = &fn;
+            job_count = jobs;
+            next.store(0, std::memory_order_relaxed);
+            busy = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        execute();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    void (*task)(void*, uint32_t) = nullptr;
+    void* task_data = nullptr;
+    uint32_t job_count = 0;
+    std::atomic<uint32_t> next{0};
+    uint32_t busy = 0;
+    uint64_t generation = 0;
+    bool quit = false;
+
+    void execute()
+    {
+        for(uint32_t j = next.fetch_add(1); j < job_count; j = next.fetch_add(1))
+        {
+            task(task_data, j);
+        }
+    }
+
+    void worker()
+    {
+        uint64_t seen = 0;
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if(quit)
+                {
+                    return;
+                }
+                seen = generation;
+            }
+
+            execute();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--busy == 0)
+            {
+                done.notify_one();
+            }
+        }
+    }
+};
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+
+namespace fren
+{
+
+//bounded lock free queue between one producer and one consumer thread, N must be a power of two
+//slots are reused in place, so buffers owned by T keep their capacity from lap to lap
+//the producer fills back() and publishes it with push(), the consumer reads front() and releases it with pop()
+//a full or empty ring blocks the waiting side on an atomic wait instead of spinning
+template<class T, uint32_t N>
+class SpscRing
+{
+    static_assert(N && (N & (N - 1)) == 0);
+
+public:
+
+    //producer side, the next slot to fill, waits while all N slots are queued
+    auto back() -> T&
+    {
+        uint32_t const h = head.load(std::memory_order_relaxed);
+        for(uint32_t t = tail.load(std::memory_order_acquire); h - t == N; t = tail.load(std::memory_order_acquire))
+        {
+            tail.wait(t, std::memory_order_acquire);
+        }
+        return slots[h & (N - 1)];
+    }
+
+    void push()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        head.notify_one();
+    }
+
+    //consumer side, the oldest queued slot, waits while none is queued
+    auto front() -> T&
+    {
+        uint32_t const t = tail.load(std::memory_order_relaxed);
+        for(uint32_t h = head.load(std::memory_order_acquire); h == t; h = head.load(std::memory_order_acquire))
+        {
+            head.wait(h, std::memory_order_acquire);
+        }
+        return slots[t & (N - 1)];
+    }
+
+    void pop()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        tail.notify_one();
+    }
+
+private:
+    std::array<T, N> slots;
+    //written by one side each, kept on separate cache lines
+    alignas(64) std::atomic<uint32_t> head{0};
+    alignas(64) std::atomic<uint32_t> tail{0};
+};
+
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "fren.hpp"
+
+namespace fren
+{
+
+//sdl backend, draws with an SDL_Renderer owned by the caller
+//batched draws set the draw color once per color and submit each color with as few calls as sdl allows
+class SDLContext : public Context
+{
+public:
+
+    explicit SDLContext(SDL_Renderer* renderer) : ren(renderer)
+    {
+    }
+
+    ~SDLContext() override
+    {
+        setAsync(false);
+    }
+
+    void plot(uint16_t x, uint16_t y, uint16_t color) override
+    {
+        setColor(color);
+        SDL_RenderDrawPoint(ren, x, y);
+    }
+
+    void line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) override
+    {
+        setColor(color);
+        SDL_RenderDrawLine(ren, x1, y1, x2, y2);
+    }
+
+    void lineHorizontal(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t color) override
+    {
+        line(x1, y1, x2, y1, color);
+    }
+
+    //one color change per color in the draw, all segments of no length of a color in one call
+    //and every run of connected segments in one SDL_RenderDrawLines call
+    //segments of different colors that overlap stack in color order instead of draw order
+    void lines(VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        order.clear();
+        for(uint32_t i = first; i + 1 < first + count; i = i + 2)
+        {
+            order.push_back((uint64_t(in.col[i]) << 32) | i);
+        }
+        std::sort(order.begin(), order.end());
+
+        for(std::size_t g = 0; g < order.size();)
+        {
+            uint16_t const color = static_cast<uint16_t>(order[g] >> 32);
+            setColor(color);
+
+            dots.clear();
+            for(; g < order.size() && static_cast<uint16_t>(order[g] >> 32) == color; ++g)
+            {
+                uint32_t const i = static_cast<uint32_t>(order[g]);
+                SDL_Point const a = point(in, i);
+                SDL_Point const b = point(in, i + 1);
+                if(a.x == b.x && a.y == b.y)
+                {
+                    dots.push_back(a);
+                    continue;
+                }
+                if(run.empty() || run.back().x != a.x || run.back().y != a.y)
+                {
+                    flushRun();
+                    run.push_back(a);
+                }
+                run.push_back(b);
+            }
+            flushRun();
+
+            if(!dots.empty())
+            {
+                SDL_RenderDrawPoints(ren, dots.data(), static_cast<int>(dots.size()));
+            }
+        }
+    }
+
+    //one SDL_RenderDrawPoints call per color in the draw
+    void points(VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        order.clear();
+        for(uint32_t i = first; i < first + count; ++i)
+        {
+            order.push_back((uint64_t(in.col[i]) << 32) | i);
+        }
+        std::sort(order.begin(), order.end());
+
+        for(std::size_t g = 0; g < order.size();)
+        {
+            uint16_t const color = static_cast<uint16_t>(order[g] >> 32);
+            setColor(color);
+
+            dots.clear();
+            for(; g < order.size() && static_cast<uint16_t>(order[g] >> 32) == color; ++g)
+            {
+                dots.push_back(point(in, static_cast<uint32_t>(order[g])));
+            }
+            SDL_RenderDrawPoints(ren, dots.data(), static_cast<int>(dots.size()));
+        }
+    }
+
+    //the spans of consecutive triangles of one color go to one SDL_RenderFillRects call, so draw order is kept
+    //rects of one row rather than SDL_RenderGeometry, whose fill rule differs, cover exactly the pixels TriangleSetup describes
+    void triangles(VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        uint16_t color = 0;
+        TriangleSetup t;
+        for(uint32_t i = first; i + 2 < first + count; i = i + 3)
+        {
+            if(!t.setup(in, i, xres, yres))
+            {
+                continue;
+            }
+            if(t.color != color)
+            {
+                flushSpans(color);
+                color = t.color;
+            }
+            for(int32_t y = t.ymin; y <= t.ymax; ++y)
+            {
+                int32_t x0, x1;
+                t.span(y, x0, x1);
+                if(x0 <= x1)
+                {
+                    spans.push_back({x0, y, x1 - x0 + 1, 1});
+                }
+            }
+        }
+        flushSpans(color);
+    }
+
+    void clear() override
+    {
+        SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+        SDL_RenderClear(ren);
+    }
+
+    void present() override
+    {
+        SDL_RenderPresent(ren);
+    }
+
+private:
+
+    SDL_Renderer* ren;
+
+    //batch scratch, color in the high half and endpoint index in the low half so sorting groups by color
+    std::vector<uint64_t> order;
+    std::vector<SDL_Point> dots;
+    std::vector<SDL_Point> run;
+    std::vector<SDL_Rect> spans;
+
+    void setColor(uint16_t const color)
+    {
+        auto const col = Convert555to888(color);
+        SDL_SetRenderDrawColor(ren, col[0], col[1], col[2], col[3]);
+    }
+
+    static auto point(VertexStream const & in, uint32_t const i) -> SDL_Point
+    {
+        return {static_cast<int16_t>(math::fromRaw(in.x[i])), static_cast<int16_t>(math::fromRaw(in.y[i]))};
+    }
+
+    void flushRun()
+    {
+        if(run.size() > 1)
+        {
+            SDL_RenderDrawLines(ren, run.data(), static_cast<int>(run.size()));
+        }
+        run.clear();
+    }
+
+    void flushSpans(uint16_t const color)
+    {
+        if(!spans.empty())
+        {
+            setColor(color);
+            SDL_RenderFillRects(ren, spans.data(), static_cast<int>(spans.size()));
+        }
+        spans.clear();
+    }
+};
+
+}
@@ -0,0 +1,183 @@
+#include "frensdl.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//the batched hooks of SDLContext against one sdl call per primitive, on the software renderer of a surface
+//runs headless on the dummy video driver
+//line and point batches stack colors in color order, so their colors get bands of the screen that do not overlap
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+
+constexpr int width = 240;
+constexpr int height = 160;
+constexpr uint16_t palette[4] = {0x001F, 0x03E0, 0x7C00, 0x7FFF};
+
+int failures = 0;
+
+//draws through the default hooks, line() per segment, plot() per point and lineHorizontal() per triangle span
+class PerCall : public fren::SDLContext
+{
+public:
+    using SDLContext::SDLContext;
+
+    void lines(fren::VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        Context::lines(in, first, count);
+    }
+
+    void points(fren::VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        Context::points(in, first, count);
+    }
+
+    void triangles(fren::VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        Context::triangles(in, first, count);
+    }
+};
+
+struct Geometry
+{
+    std::vector<vec2> verts;
+    std::vector<uint16_t> colors;
+};
+
+//pairs of vertices in the band of their color, some of no length and some leaving the view volume
+auto banded(uint32_t const per_vertex) -> Geometry
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> x(-1.3f, 1.3f);
+    std::uniform_real_distribution<float> y(0.05f, 0.45f);
+    Geometry g;
+    for(uint32_t i = 0; i < 800; ++i)
+    {
+        uint32_t const band = i / per_vertex % 4;
+        vec2 v = {fixed32(x(rng)), fixed32(-1.0f + band * 0.5f + y(rng))};
+        if(per_vertex == 2 && i % 2 == 1 && i % 7 == 1)
+        {
+            v = g.verts.back();
+        }
+        g.verts.push_back(v);
+        g.colors.push_back(palette[band]);
+    }
+    return g;
+}
+
+//one color, anywhere in and around the view
+auto single() -> Geometry
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> xy(-1.2f, 1.2f);
+    Geometry g;
+    for(uint32_t i = 0; i < 600; ++i)
+    {
+        g.verts.push_back({fixed32(xy(rng)), fixed32(xy(rng))});
+        g.colors.push_back(palette[1]);
+    }
+    return g;
+}
+
+//overlapping triangles, the color changes every few triangles and batches keep draw order
+auto layered() -> Geometry
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> center(-1.1f, 1.1f);
+    std::uniform_real_distribution<float> corner(-0.3f, 0.3f);
+    Geometry g;
+    for(uint32_t i = 0; i < 240; i += 3)
+    {
+        float const cx = center(rng);
+        float const cy = center(rng);
+        for(uint32_t k = 0; k < 3; ++k)
+        {
+            g.verts.push_back({fixed32(cx + corner(rng)), fixed32(cy + corner(rng))});
+            g.colors.push_back(palette[i / 12 % 4]);
+        }
+    }
+    return g;
+}
+
+auto render(fren::Context& ctx, SDL_Renderer* const ren, Geometry& g, fren::DrawType const dt) -> std::vector<uint32_t>
+{
+    static fren::MatrixVertexFunction identity;
+    ctx.setViewPort(width, height);
+    ctx.setVertexFunction(&identity);
+    ctx.VertexPointer(2, g.verts.data());
+    ctx.ColorPointer(g.colors.data());
+    ctx.clear();
+    ctx.DrawArray(dt, 0, g.verts.size());
+
+    std::vector<uint32_t> pixels(std::size_t(width) * height);
+    SDL_RenderReadPixels(ren, nullptr, SDL_PIXELFORMAT_ARGB8888, pixels.data(), width * sizeof(uint32_t));
+    return pixels;
+}
+
+void compare(char const* name, Geometry& g, fren::DrawType const dt)
+{
+    SDL_Surface* const surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* const ren = SDL_CreateSoftwareRenderer(surface);
+    if(surface == nullptr || ren == nullptr)
+    {
+        std::printf("%-24s FAILED, %s\n", name, SDL_GetError());
+        ++failures;
+        return;
+    }
+
+    std::vector<uint32_t> reference, batched;
+    {
+        PerCall ctx(ren);
+        reference = render(ctx, ren, g, dt);
+    }
+    {
+        fren::SDLContext ctx(ren);
+        batched = render(ctx, ren, g, dt);
+    }
+
+    uint32_t lit = 0;
+    for(uint32_t const p : reference)
+    {
+        lit += (p & 0xFFFFFF) != 0 ? 1 : 0;
+    }
+    bool const ok = lit > 0 && reference == batched;
+    std::printf("%-24s %6u pixels %s\n", name, lit, ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(surface);
+}
+
+}
+
+auto main(int /*argc*/, char* /*argv*/[]) -> int
+{
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if(SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        std::printf("SDL_Init failed, %s\n", SDL_GetError());
+        return 1;
+    }
+
+    Geometry segments = banded(2);
+    Geometry dots = banded(1);
+    Geometry path = single();
+    compare("lines", segments, fren::DrawType::Lines);
+    compare("points", dots, fren::DrawType::Points);
+    compare("line strip", path, fren::DrawType::Line_Strip);
+    compare("line loop", path, fren::DrawType::Line_Loop);
+    Geometry panels = layered();
+    compare("triangles", panels, fren::DrawType::Triangles);
+    compare("triangle strip", panels, fren::DrawType::Triangle_Strip);
+    compare("triangle fan", panels, fren::DrawType::Triangle_Fan);
+
+    SDL_Quit();
+    return failures ? 1 : 0;
+}
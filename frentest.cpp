@@ -1,64 +1,25 @@
 #include "fren.hpp"
+#include "frensdl.hpp"
 #include <SDL2/SDL.h>
 
 
-class SDLDRAWER : public fren::Context
-{
-    SDL_Window* win{};
-    SDL_Renderer* ren{};
-public:
-    SDLDRAWER()
-    {
-        SDL_CreateWindowAndRenderer(1200*2,800*2,0,&win,&ren);
-        SDL_RenderSetLogicalSize(ren, 240, 160);
-    }
-
-    auto virtual plot(uint16_t x, uint16_t y, uint16_t c) -> void override
-    {
-        auto col = fren::Convert555to888(c);
-        SDL_SetRenderDrawColor(ren,col[0],col[1],col[2],col[3]);
-        //SDL_SetRenderDrawColor(ren,255,0,0,255);
-        SDL_RenderDrawPoint(ren,x,y);
-    }
-
-    auto virtual line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) -> void override
-    {
-        auto col = fren::Convert555to888(color);
-        SDL_SetRenderDrawColor(ren,col[0],col[1],col[2],col[3]);
-        SDL_RenderDrawLine(ren, x1,y1,x2,y2);
-
-    }
-
-    auto clear() -> void override
-    {
-        SDL_SetRenderDrawColor(ren,0,0,0,255);
-        SDL_RenderClear(ren);
-    }
-
-    auto present() -> void override
-    {
-        SDL_RenderPresent(ren);
-    }
-};
-
-class VertexShader : public fren::VertexFunction
+class VertexShader : public fren::StaticVertexFunction<VertexShader>
 {
 public:
     VertexShader()
     {
-        //mv = glm::mat4(1.0f);
-        //pj = glm::ortho(0.0f,1.0f,1.0f,0.0f);
-        //pj = glm::perspective(45.0f, 1.0f, 0.2f, 1000.0f);
+        mv = fren::math::identity();
+        pj = fren::math::ortho(-1.0_fx, 1.0_fx, -1.0_fx, 1.0_fx);
+        //pj = fren::math::perspective(0.785_fx, 1.5_fx, 0.2_fx, 1000.0_fx);
 
     }
 
-    fren::math::vec4 operator() (const fren::math::vec4& in) override
+    fren::math::vec4 shade(const fren::math::vec4& in)
     {
-        //return pj * mv * in;
-        return in;
+        return pj * mv * in;
     }
 
-    //glm::mat4 mv, pj;
+    fren::math::mat4 mv, pj;
 };
 
 
@@ -76,14 +37,19 @@ uint16_t car[6] =
 
 
 
-auto main(int argc, char *argv[]) -> int
+auto main(int /*argc*/, char* /*argv*/[]) -> int
 {
 
     SDL_Init(SDL_INIT_VIDEO);
 
     VertexShader vs;
 
-    SDLDRAWER r;
+    SDL_Window* win{};
+    SDL_Renderer* ren{};
+    SDL_CreateWindowAndRenderer(1200*2,800*2,0,&win,&ren);
+    SDL_RenderSetLogicalSize(ren, 240, 160);
+
+    fren::SDLContext r(ren);
     r.setViewPort(240,160);
     r.setVertexFunction(&vs);
 
@@ -113,15 +79,12 @@ auto main(int argc, char *argv[]) -> int
 
         }
 
-        const auto sintable = fren::math::makeTable< int,30,std::sinf >;
-
-
         r.clear();
 
         r.VertexPointer(2, par);
         r.ColorPointer(car);
 
-        r.DrawArray(fren::DrawType::Line_Loop, 0, 3);
+        r.DrawArray(vs, fren::DrawType::Line_Loop, 0, 3);
 
         r.present();
 
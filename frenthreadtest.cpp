@@ -0,0 +1,94 @@
+#include "frenfb.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//the tiled line path and the banded triangle path against the serial path, pixel for pixel
+//viewports that are not multiples of the 64 pixel tile, depth testing off and on
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec3;
+
+int failures = 0;
+
+//lines and points well past PARALLEL_MIN_SEGMENTS, a third of them crossing the view volume
+struct Scene
+{
+    std::vector<vec3> verts;
+    std::vector<uint16_t> colors;
+
+    Scene()
+    {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> xy(-1.6f, 1.6f);
+        std::uniform_real_distribution<float> z(-1.1f, 1.1f);
+        verts.resize(24000);
+        colors.resize(verts.size());
+        for(std::size_t i = 0; i < verts.size(); ++i)
+        {
+            verts[i] = {{fixed32(xy(rng)), fixed32(xy(rng))}, fixed32(z(rng))};
+            colors[i] = static_cast<uint16_t>(rng() & 0x7FFF);
+        }
+    }
+};
+
+//draws every primitive type, the triangles are large enough together to take the banded path
+void render(fren::FramebufferContext& ctx, Scene& scene, uint16_t const w, uint16_t const h, uint32_t const threads, bool const depth)
+{
+    static fren::MatrixVertexFunction identity;
+    ctx.setViewPort(w, h);
+    ctx.setRasterThreads(threads);
+    ctx.setVertexFunction(&identity);
+    ctx.setDepthTest(depth);
+    ctx.VertexPointer(3, scene.verts.data());
+    ctx.ColorPointer(scene.colors.data());
+    ctx.clear();
+    ctx.DrawArray(fren::DrawType::Triangles, 0, 900);
+    ctx.DrawArray(fren::DrawType::Lines, 0, scene.verts.size());
+    ctx.DrawArray(fren::DrawType::Line_Strip, 0, scene.verts.size() / 2);
+    ctx.DrawArray(fren::DrawType::Points, 0, scene.verts.size());
+}
+
+auto same(fren::FramebufferContext const & a, fren::FramebufferContext const & b) -> bool
+{
+    for(uint16_t y = 0; y < a.height(); ++y)
+    {
+        for(uint16_t x = 0; x < a.width(); ++x)
+        {
+            if(a.pixel(x, y) != b.pixel(x, y) || a.depth(x, y) != b.depth(x, y))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+auto main() -> int
+{
+    Scene scene;
+    fren::FramebufferContext serial;
+    fren::FramebufferContext tiled;
+    for(auto const [w, h] : {std::pair<uint16_t, uint16_t>{333, 97}, {130, 250}, {64, 64}, {1, 1}, {641, 479}})
+    {
+        for(bool const depth : {false, true})
+        {
+            render(serial, scene, w, h, 1, depth);
+            for(uint32_t const threads : {2u, 3u, 7u})
+            {
+                render(tiled, scene, w, h, threads, depth);
+                bool const ok = same(serial, tiled);
+                std::printf("%4ux%-4u depth %d threads %u %s\n", w, h, depth ? 1 : 0, threads, ok ? "ok" : "FAILED");
+                failures += ok ? 0 : 1;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+#include "frenfb.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//the block rasterizer of FramebufferContext against the lineHorizontal spans of Context::triangles,
+//for every triangle draw type, cull mode and precision, serial and on 4 raster threads
+//and a closed fan whose triangles have to cover every pixel inside it exactly once
+
+namespace
+{
+
+using fren::math::fixed32;
+using fren::math::vec2;
+using fren::math::vec3;
+
+constexpr uint16_t width = 333;
+constexpr uint16_t height = 201;
+
+int failures = 0;
+
+void check(char const* name, bool const ok)
+{
+    std::printf("%-44s %s\n", name, ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+//fills through the default triangles(), one lineHorizontal per span
+class SpanContext : public fren::FramebufferContext
+{
+public:
+    void triangles(fren::VertexStream const & in, uint32_t const first, uint32_t const count) override
+    {
+        Context::triangles(in, first, count);
+    }
+};
+
+//triangles of about size around random centers in front of the camera, strips and fans share their vertices
+auto scene(float const size, uint32_t const seed) -> std::vector<vec3>
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> d(-1.6f, 1.6f);
+    std::vector<vec3> v(300);
+    float cx = 0, cy = 0, cz = 0;
+    for(uint32_t i = 0; i < v.size(); ++i)
+    {
+        if(i % 3 == 0)
+        {
+            cx = d(rng);
+            cy = d(rng);
+            cz = d(rng) * 0.8f;
+        }
+        v[i] = {{fixed32(cx + d(rng) * size), fixed32(cy + d(rng) * size)}, fixed32(cz + d(rng) * size)};
+    }
+    return v;
+}
+
+void compare(std::vector<vec3>& verts, std::vector<uint16_t>& colors, char const* size)
+{
+    char const* const types[] = {"triangles", "strip", "fan"};
+    char const* const culls[] = {"none", "back", "front"};
+    char const* const precisions[] = {"fixed", "float", "double"};
+
+    fren::MatrixVertexFunction camera;
+    camera.mvp = fren::math::perspective(1.2_fx, 1.33_fx, 0.5_fx, 50.0_fx) * fren::math::translate({{0.0_fx, 0.0_fx}, -2.0_fx});
+
+    for(uint32_t const threads : {1u, 4u})
+    {
+        for(uint8_t p = 0; p < 3; ++p)
+        {
+            for(uint8_t c = 0; c < 3; ++c)
+            {
+                for(uint8_t t = 0; t < 3; ++t)
+                {
+                    fren::FramebufferContext blocks;
+                    SpanContext spans;
+                    for(fren::FramebufferContext* ctx : {&blocks, static_cast<fren::FramebufferContext*>(&spans)})
+                    {
+                        ctx->setViewPort(width, height);
+                        ctx->setVertexFunction(&camera);
+                        ctx->setPrecision(static_cast<fren::Precision>(p));
+                        ctx->setCullFace(static_cast<fren::CullFace>(c));
+                        ctx->VertexPointer(3, verts.data());
+                        ctx->ColorPointer(colors.data());
+                        ctx->clear();
+                    }
+                    blocks.setRasterThreads(threads);
+                    fren::DrawType const dt = static_cast<fren::DrawType>(static_cast<int>(fren::DrawType::Triangles) + t);
+                    blocks.DrawArray(dt, 0, verts.size());
+                    spans.DrawArray(dt, 0, verts.size());
+
+                    bool same = true;
+                    uint32_t lit = 0;
+                    for(uint16_t y = 0; y < height; ++y)
+                    {
+                        for(uint16_t x = 0; x < width; ++x)
+                        {
+                            same = same && blocks.pixel(x, y) == spans.pixel(x, y);
+                            lit += blocks.pixel(x, y) != 0 ? 1 : 0;
+                        }
+                    }
+                    char name[64];
+                    std::snprintf(name, sizeof(name), "%s %s cull %s %s %u thread", size, types[t], culls[c], precisions[p], threads);
+                    check(name, same && lit > 0);
+                }
+            }
+        }
+    }
+}
+
+//per pixel count of the triangles of a Triangles list that cover it, each triangle drawn on its own
+auto coverage(std::vector<vec2>& verts, uint16_t const w, uint16_t const h) -> std::vector<uint8_t>
+{
+    fren::FramebufferContext ctx;
+    fren::MatrixVertexFunction identity;
+    ctx.setViewPort(w, h);
+    ctx.setVertexFunction(&identity);
+    ctx.ColorPointer(nullptr);
+    ctx.VertexPointer(2, verts.data());
+
+    std::vector<uint8_t> hits(std::size_t(w) * h, 0);
+    for(uint32_t i = 0; i + 2 < verts.size(); i = i + 3)
+    {
+        ctx.clear();
+        ctx.DrawArray(fren::DrawType::Triangles, i, 3);
+        for(uint16_t y = 0; y < h; ++y)
+        {
+            for(uint16_t x = 0; x < w; ++x)
+            {
+                hits[std::size_t(y) * w + x] += ctx.pixel(x, y) != 0 ? 1 : 0;
+            }
+        }
+    }
+    return hits;
+}
+
+//a fan around an off center point closing on itself, edges between triangles have to go to exactly one of them
+void test_fan_coverage()
+{
+    constexpr uint16_t w = 160;
+    constexpr uint16_t h = 120;
+    constexpr uint32_t spokes = 37;
+
+    std::vector<vec2> verts;
+    for(uint32_t i = 0; i < spokes; ++i)
+    {
+        float const a0 = 6.2831853f * i / spokes;
+        float const a1 = 6.2831853f * ((i + 1) % spokes) / spokes;
+        verts.push_back({0.013_fx, -0.021_fx});
+        verts.push_back({fixed32(0.9f * std::cos(a0)), fixed32(0.9f * std::sin(a0))});
+        verts.push_back({fixed32(0.9f * std::cos(a1)), fixed32(0.9f * std::sin(a1))});
+    }
+    std::vector<uint8_t> const hits = coverage(verts, w, h);
+
+    //pixel centers well inside the polygon, which is within 0.9 * cos(pi / spokes) of the center
+    uint32_t missed = 0;
+    uint32_t twice = 0;
+    for(uint16_t y = 0; y < h; ++y)
+    {
+        for(uint16_t x = 0; x < w; ++x)
+        {
+            float const nx = (x + 0.5f) / (w / 2) - 1 - 0.013f;
+            float const ny = 1 - (y + 0.5f) / (h / 2) + 0.021f;
+            uint8_t const n = hits[std::size_t(y) * w + x];
+            missed += n == 0 && nx * nx + ny * ny < 0.85f * 0.85f ? 1 : 0;
+            twice += n > 1 ? 1 : 0;
+        }
+    }
+    std::printf("fan: %u pixels missed, %u written twice\n", missed, twice);
+    check("fan covers every pixel once", missed == 0 && twice == 0);
+}
+
+//eight spokes from a pixel center along the rows, columns and diagonals, so every shared edge runs through pixel centers
+//and only the top left rule decides which triangle gets them
+void test_fan_on_pixel_centers()
+{
+    constexpr uint16_t w = 160;
+    constexpr uint16_t h = 120;
+    int32_t const rim[8][2] = {{40, 0}, {40, -40}, {0, -40}, {-40, -40}, {-40, 0}, {-40, 40}, {0, 40}, {40, 40}};
+
+    //window position of pixel 80, 60 plus an offset, nudged by less than a subpixel so the 28.4 snap lands on it
+    auto const at = [](int32_t const dx, int32_t const dy) -> vec2
+    {
+        float const wx = 80.5f + dx + 0.01f;
+        float const wy = 60.5f + dy + 0.01f;
+        return {fixed32(wx / (w / 2) - 1), fixed32(1 - wy / (h / 2))};
+    };
+
+    std::vector<vec2> verts;
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        uint32_t const n = (i + 1) % 8;
+        verts.push_back(at(0, 0));
+        verts.push_back(at(rim[i][0], rim[i][1]));
+        verts.push_back(at(rim[n][0], rim[n][1]));
+    }
+    std::vector<uint8_t> const hits = coverage(verts, w, h);
+
+    //the fan is the square of pixels 40..120, 20..100 with its outer edges on pixel centers
+    uint32_t missed = 0;
+    uint32_t twice = 0;
+    for(uint16_t y = 0; y < h; ++y)
+    {
+        for(uint16_t x = 0; x < w; ++x)
+        {
+            uint8_t const n = hits[std::size_t(y) * w + x];
+            missed += n == 0 && std::abs(x - 80) < 40 && std::abs(y - 60) < 40 ? 1 : 0;
+            twice += n > 1 ? 1 : 0;
+        }
+    }
+    std::printf("fan on pixel centers: %u pixels missed, %u written twice\n", missed, twice);
+    check("fan on pixel centers covers every pixel once", missed == 0 && twice == 0);
+}
+
+}
+
+auto main() -> int
+{
+    std::vector<uint16_t> colors(300);
+    std::mt19937 rng(5);
+    for(uint16_t& c : colors)
+    {
+        c = static_cast<uint16_t>(rng() & 0x7FFF);
+    }
+
+    //small separate triangles stay on the serial block path, large ones and the strips and fans joining them split into row bands on 4 threads
+    std::vector<vec3> small = scene(0.08f, 5);
+    std::vector<vec3> large = scene(0.6f, 6);
+    compare(small, colors, "small");
+    compare(large, colors, "large");
+    test_fan_coverage();
+    test_fan_on_pixel_centers();
+    return failures ? 1 : 0;
+}
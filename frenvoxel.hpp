@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "fren.hpp"
+#include "frenpool.hpp"
+
+namespace fren
+{
+
+//square height and color map of 1 << size_log2 texels a side, row major, sampled with wrap around
+struct Heightmap
+{
+    uint8_t const* height = nullptr;
+    uint16_t const* color = nullptr;
+    uint8_t size_log2 = 0;
+    uint8_t max_height = UINT8_MAX;   //highest value in height, a lower bound lets occluded columns stop sooner
+};
+
+//viewer of a terrain flyover, positions are in texels and heights in heightmap units
+struct TerrainCamera
+{
+    math::fixed32 x, y;
+    math::fixed32 height;
+    math::fixed32 angle;        //heading in radians, 0 looks towards -y, the field of view is 90 degrees
+    math::fixed32 horizon;      //screen row of the horizon, moving it pitches the view
+    math::fixed32 scale;        //screen rows per height unit one texel away
+    math::fixed32 distance;     //far limit
+};
+
+//voxel space terrain, every screen column marches front to back over the heightmap and draws
+//the part of each sample that rises above everything nearer as a Context::lineVertical span
+//the distance between samples grows with distance, and a column stops once nothing farther can rise above it
+//the sky above the terrain is left untouched
+class TerrainRenderer
+{
+public:
+
+    //march the columns on n threads, 1 marches on the calling thread
+    //spans always reach the context from the calling thread, so an async context has to Finish() first
+    void setThreads(uint32_t const n)
+    {
+        pool = n > 1 ? std::make_unique<WorkerPool>(n) : nullptr;
+    }
+
+    auto threads() const -> uint32_t
+    {
+        return pool ? pool->size() : 1;
+    }
+
+    //samples start one texel apart and the step grows by lod after every sample
+    void setDetail(math::fixed32 const lod)
+    {
+        detail = lod;
+    }
+
+    //spans drawn by the last render
+    auto spanCount() const -> uint32_t
+    {
+        return span_count;
+    }
+
+    //draws the terrain over the whole viewport of ctx
+    void render(Context& ctx, Heightmap const & map, TerrainCamera const & cam)
+    {
+        uint16_t const w = ctx.width();
+        uint16_t const h = ctx.height();
+        span_count = 0;
+        if(w == 0 || h == 0 || map.height == nullptr || map.color == nullptr)
+        {
+            return;
+        }
+
+        build_steps(cam, map, h);
+        //the view direction is the same for every column
+        int64_t const s = math::sin(cam.angle).data;
+        int64_t const c = math::cos(cam.angle).data;
+
+        //a few bands per thread so uneven columns even out
+        uint32_t const count = pool ? std::min<uint32_t>(pool->size() * 4, w) : 1;
+        if(bands.size() < count)
+        {
+            bands.resize(count);
+        }
+        auto march_band = [&](uint32_t const b)
+        {
+            //a column draws at most one span per step and per row, reserving that keeps later frames from allocating
+            bands[b].clear();
+            bands[b].reserve(std::size_t(w / count + 1) * std::min<std::size_t>(steps.size(), h));
+            for(uint32_t i = w * b / count; i < w * (b + 1) / count; ++i)
+            {
+                march(map, cam, s, c, i, w, h, bands[b]);
+            }
+        };
+        if(pool)
+        {
+            pool->run(count, march_band);
+        }
+        else
+        {
+            march_band(0);
+        }
+
+        for(uint32_t b = 0; b < count; ++b)
+        {
+            for(Span const & s : bands[b])
+            {
+                ctx.lineVertical(s.x, s.top, s.bottom, s.color);
+            }
+            span_count += bands[b].size();
+        }
+    }
+
+private:
+
+    struct Span
+    {
+        uint16_t x, top, bottom, color;
+    };
+
+    //one sample distance, shared by every column
+    struct Step
+    {
+        int32_t z;          //16.16 texels
+        int32_t scale;      //16.16 screen rows per height unit at z
+        int32_t reach;      //highest screen row any sample at this distance or farther can reach
+    };
+
+    std::unique_ptr<WorkerPool> pool;
+    math::fixed32 detail = 0.2_fx;
+    std::vector<Step> steps;
+    std::vector<std::vector<Span>> bands;
+    uint32_t span_count = 0;
+
+    //screen row of a sample, the first row it covers
+    static auto row(TerrainCamera const & cam, int64_t const height, int32_t const scale) -> int64_t
+    {
+        int64_t const y = cam.horizon.data + (((int64_t(cam.height.data) - (height << 16)) * scale) >> 16);
+        return (y + 0xFFFF) >> 16;
+    }
+
+    void build_steps(TerrainCamera const & cam, Heightmap const & map, uint16_t const h)
+    {
+        steps.clear();
+        int64_t dz = 65536;
+        for(int64_t z = 65536; z < cam.distance.data; z += dz, dz += std::max(detail.data, 0))
+        {
+            int32_t const scale = math::reciprocal(math::fromRaw(static_cast<int32_t>(z)))(cam.scale).data;
+            steps.push_back({static_cast<int32_t>(z), scale, 0});
+        }
+
+        //the row max_height terrain reaches at each step, a column whose ybuffer is at or above it
+        //for this step and every farther one has nothing left to draw
+        int64_t reach = h;
+        for(std::size_t k = steps.size(); k-- > 0;)
+        {
+            reach = std::min(reach, row(cam, map.max_height, steps[k].scale));
+            steps[k].reach = static_cast<int32_t>(std::clamp<int64_t>(reach, 0, h));
+        }
+    }
+
+    //s and c are the raw sin and cos of cam.angle
+    void march(Heightmap const & map, TerrainCamera const & cam, int64_t const s, int64_t const c,
+               uint32_t const i, uint16_t const w, uint16_t const h, std::vector<Span>& out) const
+    {
+        //the ray through column i one texel away, from the left edge of the view at -45 degrees to the right edge
+        int64_t const t = ((int64_t(i) * 2 + 1) << 16) / (int64_t(w) * 2);
+        int64_t const dx = -c - s + ((2 * c * t) >> 16);
+        int64_t const dy = s - c - ((2 * s * t) >> 16);
+
+        uint32_t const mask = (1u << map.size_log2) - 1;
+        std::size_t const first = out.size();
+        int64_t ybuffer = h;
+        for(Step const & st : steps)
+        {
+            if(ybuffer <= st.reach)
+            {
+                break;
+            }
+
+            uint32_t const mx = static_cast<uint32_t>((cam.x.data + ((dx * st.z) >> 16)) >> 16) & mask;
+            uint32_t const my = static_cast<uint32_t>((cam.y.data + ((dy * st.z) >> 16)) >> 16) & mask;
+            uint32_t const texel = (my << map.size_log2) | mx;
+            int64_t const top = std::max<int64_t>(row(cam, map.height[texel], st.scale), 0);
+            if(top >= ybuffer)
+            {
+                continue;
+            }
+
+            //a span right on top of one with the same color extends it
+            uint16_t const color = map.color[texel];
+            if(out.size() > first && out.back().color == color && out.back().top == ybuffer)
+            {
+                out.back().top = static_cast<uint16_t>(top);
+            }
+            else
+            {
+                out.push_back({static_cast<uint16_t>(i), static_cast<uint16_t>(top), static_cast<uint16_t>(ybuffer - 1), color});
+            }
+            ybuffer = top;
+        }
+    }
+};
+
+}